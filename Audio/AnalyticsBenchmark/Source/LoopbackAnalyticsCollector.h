@@ -0,0 +1,258 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE tutorials.
+   Copyright (c) 2020 - Raw Material Software Limited
+
+   The code included in this file is provided under the terms of the ISC license
+   http://www.isc.org/downloads/software-support-policy/isc-license. Permission
+   To use, copy, modify, and/or distribute this software for any purpose with or
+   without fee is hereby granted provided that the above copyright notice and
+   this permission notice appear in all copies.
+
+   THE SOFTWARE IS PROVIDED "AS IS" WITHOUT ANY WARRANTY, AND ALL WARRANTIES,
+   WHETHER EXPRESSED OR IMPLIED, INCLUDING MERCHANTABILITY AND FITNESS FOR
+   PURPOSE, ARE DISCLAIMED.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+//==============================================================================
+/**
+    A stand-in for the Google Analytics /batch endpoint, listening on the
+    loopback interface, so that GoogleAnalyticsDestination can be run under load
+    without a network.
+
+    It accepts POSTs to /batch, counts the hits in each one (one per line), and
+    records how long each request took from being accepted until the response
+    was written. It can be told to fail a proportion of requests with a 503, or
+    to answer some of them slowly.
+
+    Requests are handled one at a time, which is all the destination needs, as
+    it only sends one batch at a time.
+*/
+class LoopbackAnalyticsCollector  : private juce::Thread
+{
+public:
+    struct Options
+    {
+        double failureProbability = 0.0;   // the proportion of requests answered with a 503
+        double slowProbability = 0.0;      // the proportion answered after slowResponseMs
+        int slowResponseMs = 0;
+    };
+
+    explicit LoopbackAnalyticsCollector (const Options& optionsToUse)
+        : juce::Thread ("LoopbackAnalyticsCollector"),
+          options (optionsToUse)
+    {
+    }
+
+    ~LoopbackAnalyticsCollector() override
+    {
+        stop();
+    }
+
+    /** Starts listening on a free port. Returns false if it couldn't. */
+    bool start()
+    {
+        if (! listener.createListener (0, "127.0.0.1"))
+            return false;
+
+        startThread();
+        return true;
+    }
+
+    void stop()
+    {
+        signalThreadShouldExit();
+        listener.close();
+        stopThread (stopTimeoutMs);
+    }
+
+    /** Returns the URL to send batches to. */
+    juce::URL getURL() const
+    {
+        return juce::URL ("http://127.0.0.1:" + juce::String (listener.getBoundPort()) + "/batch");
+    }
+
+    //==============================================================================
+    struct Statistics
+    {
+        int numRequests = 0, numFailedRequests = 0, numSlowRequests = 0;
+        juce::int64 numHitsAccepted = 0, numHitsRejected = 0;
+        std::vector<double> latenciesMs;    // in the order the requests arrived
+
+        /** Returns the latency below which a proportion of the requests were
+            answered, e.g. 0.99 for the 99th percentile.
+        */
+        double getLatencyPercentile (double proportion) const
+        {
+            if (latenciesMs.empty())
+                return 0.0;
+
+            auto sorted = latenciesMs;
+            auto index = (size_t) juce::roundToInt (proportion * (double) (sorted.size() - 1));
+            std::nth_element (sorted.begin(), sorted.begin() + (std::ptrdiff_t) index, sorted.end());
+            return sorted[index];
+        }
+    };
+
+    Statistics getStatistics() const
+    {
+        const juce::ScopedLock lock (statisticsLock);
+        return statistics;
+    }
+
+    juce::int64 getNumHitsAccepted() const
+    {
+        const juce::ScopedLock lock (statisticsLock);
+        return statistics.numHitsAccepted;
+    }
+
+private:
+    //==============================================================================
+    static constexpr int stopTimeoutMs = 2000;
+    static constexpr int readTimeoutMs = 5000;
+    static constexpr int maximumHeaderSize = 16 * 1024;
+
+    void run() override
+    {
+        while (! threadShouldExit())
+        {
+            std::unique_ptr<juce::StreamingSocket> connection (listener.waitForNextConnection());
+
+            if (connection != nullptr && ! threadShouldExit())
+                handleRequest (*connection);
+        }
+    }
+
+    void handleRequest (juce::StreamingSocket& connection)
+    {
+        auto startTicks = juce::Time::getHighResolutionTicks();
+
+        juce::MemoryBlock body;
+        juce::String requestLine;
+
+        if (! readRequest (connection, requestLine, body))
+            return;
+
+        if (! requestLine.startsWith ("POST /batch "))
+        {
+            writeResponse (connection, "404 Not Found");
+            return;
+        }
+
+        auto numHits = countHits (body);
+        auto shouldFail = random.nextDouble() < options.failureProbability;
+        auto shouldBeSlow = random.nextDouble() < options.slowProbability;
+
+        if (shouldBeSlow)
+            juce::Thread::sleep (options.slowResponseMs);
+
+        writeResponse (connection, shouldFail ? "503 Service Unavailable" : "200 OK");
+
+        auto latencyMs = juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - startTicks) * 1000.0;
+
+        const juce::ScopedLock lock (statisticsLock);
+
+        ++statistics.numRequests;
+        statistics.latenciesMs.push_back (latencyMs);
+
+        if (shouldBeSlow)
+            ++statistics.numSlowRequests;
+
+        if (shouldFail)
+        {
+            ++statistics.numFailedRequests;
+            statistics.numHitsRejected += numHits;
+        }
+        else
+        {
+            statistics.numHitsAccepted += numHits;
+        }
+    }
+
+    // Reads the headers and then as many bytes of body as Content-Length gives.
+    static bool readRequest (juce::StreamingSocket& connection, juce::String& requestLine, juce::MemoryBlock& body)
+    {
+        juce::MemoryOutputStream received;
+        char buffer[4096];
+        int headerEnd = -1;
+
+        while (headerEnd < 0)
+        {
+            if (received.getDataSize() > (size_t) maximumHeaderSize || connection.waitUntilReady (true, readTimeoutMs) != 1)
+                return false;
+
+            auto numRead = connection.read (buffer, (int) sizeof (buffer), false);
+
+            if (numRead <= 0)
+                return false;
+
+            received.write (buffer, (size_t) numRead);
+            headerEnd = received.toString().indexOf ("\r\n\r\n");
+        }
+
+        auto headers = juce::StringArray::fromLines (received.toString().substring (0, headerEnd));
+        requestLine = headers[0];
+
+        juce::int64 contentLength = 0;
+
+        for (auto& header : headers)
+        {
+            if (header.startsWithIgnoreCase ("Content-Length:"))
+                contentLength = header.fromFirstOccurrenceOf (":", false, false).trim().getLargeIntValue();
+            else if (header.startsWithIgnoreCase ("Expect:") && header.containsIgnoreCase ("100-continue"))
+                writeText (connection, "HTTP/1.1 100 Continue\r\n\r\n");
+        }
+
+        auto bodyStart = (size_t) headerEnd + 4;
+        body.append (juce::addBytesToPointer (received.getData(), bodyStart), received.getDataSize() - bodyStart);
+
+        while ((juce::int64) body.getSize() < contentLength)
+        {
+            if (connection.waitUntilReady (true, readTimeoutMs) != 1)
+                return false;
+
+            auto numRead = connection.read (buffer, (int) juce::jmin ((juce::int64) sizeof (buffer), contentLength - (juce::int64) body.getSize()), false);
+
+            if (numRead <= 0)
+                return false;
+
+            body.append (buffer, (size_t) numRead);
+        }
+
+        return true;
+    }
+
+    static juce::int64 countHits (const juce::MemoryBlock& body)
+    {
+        if (body.isEmpty())
+            return 0;
+
+        auto* data = static_cast<const char*> (body.getData());
+        return 1 + std::count (data, data + body.getSize(), '\n');
+    }
+
+    static void writeResponse (juce::StreamingSocket& connection, const juce::String& status)
+    {
+        writeText (connection, "HTTP/1.1 " + status + "\r\nContent-Length: 0\r\nConnection: close\r\n\r\n");
+    }
+
+    static void writeText (juce::StreamingSocket& connection, const juce::String& text)
+    {
+        connection.write (text.toRawUTF8(), (int) text.getNumBytesAsUTF8());
+    }
+
+    //==============================================================================
+    const Options options;
+    juce::StreamingSocket listener;
+    juce::Random random;
+
+    juce::CriticalSection statisticsLock;
+    Statistics statistics;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LoopbackAnalyticsCollector)
+};
@@ -0,0 +1,356 @@
+/*
+  ==============================================================================
+
+    Headless benchmark for the analytics code in AnalyticsCollectionTutorial.
+
+    Encodes batches of events into Google Analytics payloads in two ways: the
+    way logBatchedEvents() used to, with a StringPairArray per event and
+    URL::addEscapeChars on every value, and with AnalyticsPayloadEncoder. Each
+    run reports the time and heap allocations per event. Exits with an error if
+    the two payloads differ, or if the encoder takes a microsecond or more per
+    event or allocates per event.
+
+    Then drives a GoogleAnalyticsDestination against a LoopbackAnalyticsCollector
+    on 127.0.0.1, once with a healthy collector, once with one that fails a tenth
+    of the requests, and once with one that answers a tenth of them slowly. Each
+    run reports the events delivered per second, the collector's request latency
+    percentiles, how many batches the destination had to retry and how many
+    events its circuit breaker moved to disk, and fails if the events aren't all
+    delivered within a minute. Usage:
+
+        AnalyticsBenchmark [--events=1000000] [--load-events=20000]
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../AnalyticsCollectionTutorial/Source/AnalyticsCollectionTutorial.h"
+#include "LoopbackAnalyticsCollector.h"
+
+//==============================================================================
+// Every heap allocation in the process goes through here so that each benchmark
+// can report how many it made.
+static std::atomic<juce::int64> numAllocations { 0 };
+
+void* operator new (std::size_t size)
+{
+    ++numAllocations;
+
+    if (auto* p = std::malloc (size == 0 ? 1 : size))
+        return p;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[] (std::size_t size)                  { return operator new (size); }
+void operator delete (void* p) noexcept                  { std::free (p); }
+void operator delete[] (void* p) noexcept                { std::free (p); }
+void operator delete (void* p, std::size_t) noexcept     { std::free (p); }
+void operator delete[] (void* p, std::size_t) noexcept   { std::free (p); }
+
+//==============================================================================
+namespace
+{
+    using AnalyticsEvent = juce::AnalyticsDestination::AnalyticsEvent;
+
+    struct BenchmarkResult
+    {
+        double nanosecondsPerEvent = 0.0;
+        juce::int64 numAllocations = 0;
+        juce::int64 numBytes = 0;
+    };
+
+    const juce::String apiKey ("UA-XXXXXXXXX-1");
+    constexpr int batchSize = 20;
+    constexpr int numSampleEvents = 1000;
+
+    // A mix of the tutorial's events. Some of the button IDs need escaping.
+    juce::Array<AnalyticsEvent> createSampleEvents()
+    {
+        const char* const buttonIds[] = { "a", "b", "play", "stop", "save as", "preset:1/2", "caf\xc3\xa9" };
+
+        juce::StringPairArray userProperties;
+        userProperties.set ("group", "beta");
+
+        juce::Array<AnalyticsEvent> events;
+        juce::Random random (42);
+
+        for (int i = 0; i < numSampleEvents; ++i)
+        {
+            juce::String name;
+            juce::StringPairArray parameters;
+
+            switch (random.nextInt (5))
+            {
+                case 0:  name = "startup"; break;
+                case 1:  name = "shutdown"; break;
+                case 2:  name = "crash"; break;
+
+                case 3:
+                    name = "audio_overload";
+                    parameters.set ("block_size", juce::String (64 << random.nextInt (5)));
+                    break;
+
+                default:
+                    name = "button_press";
+                    parameters.set ("id", juce::CharPointer_UTF8 (buttonIds[random.nextInt ((int) juce::numElementsInArray (buttonIds))]));
+                    break;
+            }
+
+            events.add ({ name, DemoAnalyticsEventTypes::event, (juce::uint32) i, parameters, "AnonUser1234", userProperties });
+        }
+
+        return events;
+    }
+
+    //==============================================================================
+    // What logBatchedEvents() did before AnalyticsPayloadEncoder.
+    juce::String encodeWithStrings (const AnalyticsEvent* events, int numEvents)
+    {
+        juce::String appData ("v=1&aip=1&tid=" + apiKey);
+        juce::StringArray postData;
+
+        for (int i = 0; i < numEvents; ++i)
+        {
+            auto& event = events[i];
+            juce::StringPairArray data;
+            data.set ("t", "event");
+
+            if (event.name == "startup")
+            {
+                data.set ("ec", "info");
+                data.set ("ea", "appStarted");
+            }
+            else if (event.name == "shutdown")
+            {
+                data.set ("ec", "info");
+                data.set ("ea", "appStopped");
+            }
+            else if (event.name == "button_press")
+            {
+                data.set ("ec", "button_press");
+                data.set ("ea", event.parameters["id"]);
+            }
+            else if (event.name == "crash")
+            {
+                data.set ("ec", "crash");
+                data.set ("ea", "crash");
+            }
+            else if (event.name == "audio_overload")
+            {
+                data.set ("ec", "audio");
+                data.set ("ea", "overload");
+                data.set ("el", "block_size_" + event.parameters["block_size"]);
+            }
+
+            data.set ("cid", event.userID);
+
+            juce::StringArray eventData;
+
+            for (auto& key : data.getAllKeys())
+                eventData.add (key + "=" + juce::URL::addEscapeChars (data[key], true));
+
+            postData.add (appData + "&" + eventData.joinIntoString ("&"));
+        }
+
+        return postData.joinIntoString ("\n");
+    }
+
+    //==============================================================================
+    template <typename EncodeFunction>
+    BenchmarkResult runBenchmark (const juce::String& name, int numEvents, EncodeFunction&& encode)
+    {
+        // One batch first, so that any buffers that are kept between batches
+        // have already grown to size.
+        encode (0);
+
+        auto allocationsBefore = numAllocations.load();
+        auto startTicks = juce::Time::getHighResolutionTicks();
+        juce::int64 numBytes = 0;
+
+        for (int start = 0; start < numEvents; start += batchSize)
+            numBytes += (juce::int64) encode (start % (numSampleEvents - batchSize));
+
+        auto seconds = juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - startTicks);
+        auto allocations = numAllocations.load() - allocationsBefore;
+
+        BenchmarkResult result { seconds * 1.0e9 / numEvents, allocations, numBytes };
+
+        std::cout << name.paddedRight (' ', 28)
+                  << juce::String (result.nanosecondsPerEvent, 1).paddedLeft (' ', 12) << " ns/event"
+                  << juce::String ((double) numEvents / seconds, 0).paddedLeft (' ', 14) << " events/s"
+                  << juce::String ((double) allocations / numEvents, 2).paddedLeft (' ', 10) << " allocations/event"
+                  << juce::File::descriptionOfSizeInBytes (numBytes).paddedLeft (' ', 12) << std::endl;
+
+        return result;
+    }
+
+    bool runPayloadBenchmarks (int numEvents)
+    {
+        auto events = createSampleEvents();
+
+        AnalyticsPayloadEncoder encoder (apiKey);
+        GoogleAnalyticsDestination::addEventMappings (encoder);
+
+        auto encodeBatch = [&] (int start)
+        {
+            encoder.startBatch();
+
+            for (int i = start; i < start + batchSize; ++i)
+                encoder.addEvent (events.getReference (i));
+
+            return encoder.getDataSize();
+        };
+
+        bool allPassed = true;
+
+        for (int start = 0; start + batchSize <= numSampleEvents; start += batchSize)
+        {
+            auto expected = encodeWithStrings (events.begin() + start, batchSize);
+            encodeBatch (start);
+
+            if (expected.getNumBytesAsUTF8() != encoder.getDataSize()
+                 || memcmp (expected.toRawUTF8(), encoder.getData(), encoder.getDataSize()) != 0)
+            {
+                std::cout << "FAILED: AnalyticsPayloadEncoder's payload differs for the batch at event " << start << std::endl;
+                allPassed = false;
+                break;
+            }
+        }
+
+        std::cout << std::endl << "Payload encoding, " << numEvents << " events in batches of " << batchSize << std::endl;
+
+        runBenchmark ("StringPairArray (old)", numEvents,
+                      [&] (int start) { return (size_t) encodeWithStrings (events.begin() + start, batchSize).getNumBytesAsUTF8(); });
+
+        auto result = runBenchmark ("AnalyticsPayloadEncoder", numEvents, encodeBatch);
+
+        // The encoder may allocate a few times if it meets a longer batch than
+        // the ones before, but never once per event.
+        const juce::int64 maxFixedAllocations = 16;
+
+        if (result.numAllocations > maxFixedAllocations)
+        {
+            std::cout << "FAILED: AnalyticsPayloadEncoder made " << result.numAllocations << " allocations for "
+                      << numEvents << " events" << std::endl;
+            allPassed = false;
+        }
+
+        if (result.nanosecondsPerEvent >= 1000.0)
+        {
+            std::cout << "FAILED: AnalyticsPayloadEncoder took " << result.nanosecondsPerEvent << " ns per event" << std::endl;
+            allPassed = false;
+        }
+
+        return allPassed;
+    }
+
+    //==============================================================================
+    struct LoadScenario
+    {
+        const char* name;
+        LoopbackAnalyticsCollector::Options options;
+    };
+
+    const LoadScenario loadScenarios[] =
+    {
+        { "healthy",       { 0.0, 0.0, 0 } },
+        { "10% failures",  { 0.1, 0.0, 0 } },
+        { "10% slow",      { 0.0, 0.1, 200 } }
+    };
+
+    constexpr int loadTestBatchPeriodMs = 1;
+    constexpr int loadTestTimeoutMs = 60000;
+
+    bool runLoadTest (const LoadScenario& scenario, int numEvents)
+    {
+        LoopbackAnalyticsCollector collector (scenario.options);
+
+        if (! collector.start())
+        {
+            std::cout << "FAILED: couldn't start the loopback collector" << std::endl;
+            return false;
+        }
+
+        auto savedEventsDirectory = juce::File::getSpecialLocation (juce::File::tempDirectory)
+                                        .getNonexistentChildFile ("AnalyticsBenchmark", {}, false);
+
+        juce::StringPairArray parameters;
+        parameters.set ("id", "load_test");
+
+        auto startTicks = juce::Time::getHighResolutionTicks();
+        auto deadline = juce::Time::getMillisecondCounter() + (juce::uint32) loadTestTimeoutMs;
+        int numBatchesRetried = 0, numEventsSpilled = 0;
+
+        {
+            GoogleAnalyticsDestination destination (collector.getURL(), savedEventsDirectory,
+                                                    loadTestBatchPeriodMs);
+
+            for (int i = 0; i < numEvents; ++i)
+                destination.logEvent ({ "button_press", DemoAnalyticsEventTypes::event, juce::Time::getMillisecondCounter(),
+                                        parameters, "LoadTestUser", {} });
+
+            while (collector.getNumHitsAccepted() < numEvents && juce::Time::getMillisecondCounter() < deadline)
+                juce::Thread::sleep (10);
+
+            numBatchesRetried = destination.getNumBatchesRetried();
+            numEventsSpilled = destination.getNumEventsSpilled();
+        }
+
+        auto seconds = juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - startTicks);
+        collector.stop();
+        savedEventsDirectory.deleteRecursively();
+
+        auto stats = collector.getStatistics();
+
+        std::cout << juce::String (scenario.name).paddedRight (' ', 16)
+                  << juce::String ((double) stats.numHitsAccepted / seconds, 0).paddedLeft (' ', 10) << " events/s"
+                  << "   batches: " << stats.numRequests
+                  << "   failed: " << stats.numFailedRequests
+                  << "   retried: " << numBatchesRetried
+                  << "   spilled: " << numEventsSpilled
+                  << "   slow: " << stats.numSlowRequests
+                  << "   latency ms p50/p90/p99/max: "
+                  << juce::String (stats.getLatencyPercentile (0.5), 2) << " / "
+                  << juce::String (stats.getLatencyPercentile (0.9), 2) << " / "
+                  << juce::String (stats.getLatencyPercentile (0.99), 2) << " / "
+                  << juce::String (stats.getLatencyPercentile (1.0), 2) << std::endl;
+
+        if (stats.numHitsAccepted < numEvents)
+        {
+            std::cout << "FAILED: only " << stats.numHitsAccepted << " of " << numEvents << " events were delivered" << std::endl;
+            return false;
+        }
+
+        return true;
+    }
+
+    bool runLoadTests (int numEvents)
+    {
+        std::cout << std::endl << "Load test, " << numEvents << " events through a loopback collector" << std::endl;
+
+        bool allPassed = true;
+
+        for (auto& scenario : loadScenarios)
+            allPassed &= runLoadTest (scenario, numEvents);
+
+        return allPassed;
+    }
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    juce::ArgumentList args (argc, argv);
+
+    auto numEvents = args.containsOption ("--events") ? args.getValueForOption ("--events").getIntValue()
+                                                      : 1000000;
+
+    auto numLoadEvents = args.containsOption ("--load-events") ? args.getValueForOption ("--load-events").getIntValue()
+                                                               : 20000;
+
+    bool allPassed = runPayloadBenchmarks (juce::jmax (batchSize, numEvents));
+    allPassed &= runLoadTests (juce::jmax (1, numLoadEvents));
+
+    return allPassed ? 0 : 1;
+}
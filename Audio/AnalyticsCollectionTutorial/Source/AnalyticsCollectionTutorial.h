@@ -45,6 +45,10 @@
 
 #pragma once
 
+#include "AnalyticsEventLog.h"
+#include "RealtimeAnalyticsLogger.h"
+#include "AnalyticsPayloadEncoder.h"
+
 enum DemoAnalyticsEventTypes
 {
     event,
@@ -59,18 +63,32 @@ class GoogleAnalyticsDestination  : public juce::ThreadedAnalyticsDestination
 {
 public:
     GoogleAnalyticsDestination()
-        : ThreadedAnalyticsDestination ("GoogleAnalyticsThread")
+        : GoogleAnalyticsDestination (juce::URL ("https://www.google-analytics.com/batch"),
+                                      juce::File::getSpecialLocation (juce::File::userApplicationDataDirectory)
+                                          .getChildFile (juce::JUCEApplication::getInstance()->getApplicationName()))
     {
+    }
+
+    /** Creates a destination that sends to a different endpoint, such as a local
+        collector for testing, and saves unsent events in the given directory.
+        The batch period must be at least 1ms, as the backoff doubles it.
+    */
+    GoogleAnalyticsDestination (const juce::URL& endpointToUse, const juce::File& appDataDir,
+                                int batchPeriodMs = 1000)
+        : ThreadedAnalyticsDestination ("GoogleAnalyticsThread"),
+          initialPeriodMs (juce::jmax (1, batchPeriodMs)),
+          endpoint (endpointToUse)
+    {
+        jassert (batchPeriodMs >= 1);
+
         {
             // Choose where to save any unsent events.
 
-            auto appDataDir = juce::File::getSpecialLocation (juce::File::userApplicationDataDirectory)
-                                   .getChildFile (juce::JUCEApplication::getInstance()->getApplicationName());  // [1]
-
-            if (! appDataDir.exists())
+            if (! appDataDir.exists())                                                                          // [1]
                 appDataDir.createDirectory();                                                                   // [2]
 
-            savedEventsFile = appDataDir.getChildFile ("analytics_events.xml");                                 // [3]
+            eventLog.reset (new AnalyticsEventLog (appDataDir.getChildFile ("analytics_events.log")));          // [3]
+            legacyEventsFile = appDataDir.getChildFile ("analytics_events.xml");
         }
 
         {
@@ -83,90 +101,88 @@ public:
             apiKey = "UA-XXXXXXXXX-1";
         }
 
+        {
+            // Everything about a hit that doesn't change from one event to the
+            // next is escaped once, here, rather than for every event sent.
+
+            encoder.reset (new AnalyticsPayloadEncoder (apiKey));
+            addEventMappings (*encoder);
+        }
+
         startAnalyticsThread (initialPeriodMs);                                                                 // [4]
     }
 
     ~GoogleAnalyticsDestination() override
     {
-        // Here we sleep so that our background thread has a chance to send the
-        // last lot of batched events. Be careful - if your app takes too long to
-        // shut down then some operating systems will kill it forcibly!
-        juce::Thread::sleep (initialPeriodMs);  // [5]
+        // Here we give our background thread a chance to send the last lot of
+        // batched events, if there are any. Be careful - if your app takes too
+        // long to shut down then some operating systems will kill it forcibly!
+        // Anything that isn't sent in time is saved to disk when the thread stops.
+        flush (shutdownFlushTimeoutMs);         // [5]
 
         stopAnalyticsThread (1000);             // [6]
     }
 
-    int getMaximumBatchSize() override   { return 20; }
+    /** Sets how long the destructor waits for queued events to be sent. */
+    void setShutdownFlushTimeout (int timeoutMs) noexcept     { shutdownFlushTimeoutMs = timeoutMs; }
 
-    bool logBatchedEvents (const juce::Array<AnalyticsEvent>& events) override
-    {
-        // Send events to Google Analytics.
+    /** Returns the number of batches that failed to send and went back on the
+        queue to be sent again.
+    */
+    int getNumBatchesRetried() const noexcept                 { return numBatchesRetried; }
 
-        juce::String appData ("v=1&aip=1&tid=" + apiKey);       // [1]
+    /** Returns the number of events that were moved to disk instead of being
+        sent, because the circuit breaker was open.
+    */
+    int getNumEventsSpilled() const noexcept                  { return numEventsSpilled; }
 
-        juce::StringArray postData;
+    int getMaximumBatchSize() override   { return 20; }
 
-        for (auto& event : events)                              // [2]
+    bool logBatchedEvents (const juce::Array<AnalyticsEvent>& events) override
+    {
+        // While the endpoint is down, batches are moved to disk instead of
+        // piling up in memory, apart from one every so often that's sent to see
+        // whether it's back.
+        if (circuitIsOpen && ! isTimeToProbe())
         {
-            juce::StringPairArray data;
-
-            switch (event.eventType)
+            // The probe batch is held at the front of the queue until it's time
+            // to send it.
+            if (probeBatchIsQueued)
             {
-                case (DemoAnalyticsEventTypes::event):
-                {
-                    data.set ("t", "event");
-
-                    if (event.name == "startup")
-                    {
-                        data.set ("ec",  "info");
-                        data.set ("ea",  "appStarted");
-                    }
-                    else if (event.name == "shutdown")
-                    {
-                        data.set ("ec",  "info");
-                        data.set ("ea",  "appStopped");
-                    }
-                    else if (event.name == "button_press")
-                    {
-                        data.set ("ec",  "button_press");
-                        data.set ("ea",  event.parameters["id"]);
-                    }
-                    else if (event.name == "crash")
-                    {
-                        data.set ("ec",  "crash");
-                        data.set ("ea",  "crash");
-                    }
-                    else
-                    {
-                        jassertfalse;
-                        continue;
-                    }
-
-                    break;
-                }
-
-                default:
-                {
-                    // Unknown event type! In this demo app we're just using a
-                    // single event type, but in a real app you probably want to
-                    // handle multiple ones.
-                    jassertfalse;
-                    break;
-                }
+                setBatchPeriod (juce::jmax (1, millisecondsUntilProbe()));
+                return false;
             }
 
-            data.set ("cid", event.userID);                                 // [3]
+            spillToDisk (events);
 
-            juce::StringArray eventData;
+            // Nothing would be sent again until another event was logged if the
+            // queue was left empty, so the oldest events in the log are queued to
+            // probe with.
+            if (getNumEventsQueued() == 0 && eventLog->getNumUnacknowledgedEvents() > 0)
+                queueProbeBatch();
 
-            for (auto& key : data.getAllKeys())                             // [4]
-                eventData.add (key + "=" + juce::URL::addEscapeChars (data[key], true));
+            setBatchPeriod (getNumEventsQueued() > 0 && ! probeBatchIsQueued ? spillPeriodMs
+                                                                             : juce::jmax (1, millisecondsUntilProbe()));
+            batchAttempted.signal();
+            return true;
+        }
+
+        probeBatchIsQueued = false;
+
+        // Send events to Google Analytics.
+
+        encoder->startBatch();                                      // [1]
 
-            postData.add (appData + "&" + eventData.joinIntoString ("&"));  // [5]
+        for (auto& event : events)                                  // [2]
+        {
+            // Unknown event type or name! In this demo app we're just using a
+            // single event type, but in a real app you probably want to handle
+            // multiple ones.
+            if (event.eventType != DemoAnalyticsEventTypes::event || ! encoder->addEvent (event))
+                jassertfalse;
         }
 
-        auto url = juce::URL ("https://www.google-analytics.com/batch")
-                       .withPOSTData (postData.joinIntoString ("\n"));      // [6]
+        auto url = endpoint.withPOSTData (encoder->getBatch());     // [3]
 
         {
             const juce::ScopedLock lock (webStreamCreation);        // [1]
@@ -177,19 +193,53 @@ public:
             webStream.reset (new juce::WebInputStream (url, true)); // [3]
         }
 
-        auto success = webStream->connect (nullptr);                // [4]
+        // A collector that's overloaded may answer with an error status, in
+        // which case the batch has to be sent again.
+        auto success = webStream->connect (nullptr)                 // [4]
+                        && webStream->getStatusCode() / 100 == 2;
 
-        // Do an exponential backoff if we failed to connect.
+        // Back off if we failed to connect, and speed up again gradually once
+        // we can, so a collector that's just recovered isn't flooded.
         if (success)
-            periodMs = initialPeriodMs;
+            sendSucceeded (events.size());
         else
-            periodMs *= 2;
+            sendFailed();
 
-        setBatchPeriod (periodMs);                                  // [5]
+        setBatchPeriod (isFlushing ? flushPeriodMs : periodMs);     // [5]
+        batchAttempted.signal();
 
         return success;
     }
 
+    /** Adds the fields that each of our events is sent to Google Analytics with. */
+    static void addEventMappings (AnalyticsPayloadEncoder& encoderToUse)
+    {
+        auto fields = [] (const char* category, const char* action)
+        {
+            juce::StringPairArray result;
+            result.set ("t",  "event");
+            result.set ("ec", category);
+
+            if (action != nullptr)
+                result.set ("ea", action);
+
+            return result;
+        };
+
+        // The block size goes in the label as "block_size_512", as it did before
+        // the encoder was added, so the hits match the ones already collected.
+        juce::StringPairArray buttonId, blockSize, blockSizeLabel;
+        buttonId.set ("ea", "id");
+        blockSize.set ("el", "block_size");
+        blockSizeLabel.set ("el", "block_size_");
+
+        encoderToUse.addEventMapping ("startup",        fields ("info", "appStarted"));
+        encoderToUse.addEventMapping ("shutdown",       fields ("info", "appStopped"));
+        encoderToUse.addEventMapping ("button_press",   fields ("button_press", nullptr), buttonId);
+        encoderToUse.addEventMapping ("crash",          fields ("crash", "crash"));
+        encoderToUse.addEventMapping ("audio_overload", fields ("audio", "overload"), blockSize, blockSizeLabel);
+    }
+
     void stopLoggingEvents() override
     {
         const juce::ScopedLock lock (webStreamCreation);            // [1]
@@ -200,102 +250,368 @@ public:
             webStream->cancel();
     }
 
+    // Keeps track of which queued events were restored from the log.
+    void logEvent (const AnalyticsEvent& event) override
+    {
+        const juce::ScopedLock lock (queuedRunsLock);
+
+        addQueuedRun (false, 1);
+        ThreadedAnalyticsDestination::logEvent (event);
+    }
+
 private:
     void saveUnloggedEvents (const std::deque<AnalyticsEvent>& eventsToSave) override
     {
-        // Save unsent events to disk. Here we use XML as a serialisation format, but
-        // you can use anything else as long as the restoreUnloggedEvents method can
-        // restore events from disk. If you're saving very large numbers of events then
-        // a binary format may be more suitable if it is faster - remember that this
-        // method is called on app shutdown so it needs to complete quickly!
+        // Save unsent events to disk. They're appended to a binary log, so saving
+        // takes the same time however many events were left over from earlier
+        // runs - remember that this method is called on app shutdown so it needs
+        // to complete quickly!
+        //
+        // The events in the queue that were restored from the log are still in
+        // it, so only the ones in between them need adding.
 
-        juce::XmlDocument previouslySavedEvents (savedEventsFile);
-        std::unique_ptr<juce::XmlElement> xml (previouslySavedEvents.getDocumentElement()); // [1]
+        const juce::ScopedLock lock (queuedRunsLock);
 
-        if (xml.get() == nullptr || xml->getTagName() != "events")                          // [2]
-            xml.reset (new juce::XmlElement ("events"));
+        auto it = eventsToSave.begin();
 
-        for (auto& event : eventsToSave)
+        for (auto& run : queuedRuns)
         {
-            auto* xmlEvent = new juce::XmlElement ("google_analytics_event");               // [3]
-            xmlEvent->setAttribute ("name", event.name);
-            xmlEvent->setAttribute ("type", event.eventType);
-            xmlEvent->setAttribute ("timestamp", (int) event.timestamp);
-            xmlEvent->setAttribute ("user_id", event.userID);
+            auto numInRun = juce::jmin ((std::ptrdiff_t) run.numEvents, eventsToSave.end() - it);
 
-            auto* parameters = new juce::XmlElement ("parameters");                         // [4]
+            if (! run.isFromLog)
+                eventLog->append (it, it + numInRun);
 
-            for (auto& key : event.parameters.getAllKeys())
-                parameters->setAttribute (key, event.parameters[key]);
+            it += numInRun;
+        }
 
-            xmlEvent->addChildElement (parameters);
+        eventLog->append (it, eventsToSave.end());
+    }
 
-            auto* userProperties = new juce::XmlElement ("user_properties");                // [5]
+    void restoreUnloggedEvents (std::deque<AnalyticsEvent>& restoredEventQueue) override
+    {
+        // The events stay in the log until they've been sent, so none are lost if
+        // the app quits or crashes first. Only the oldest few are restored here,
+        // and the rest follow as these are sent, so a large backlog doesn't hold
+        // up startup or fill memory.
+        migrateLegacyEvents();
+
+        auto numRestored = eventLog->restore (restoredEventQueue, maxRestoredEventsQueued);
+
+        const juce::ScopedLock lock (queuedRunsLock);
+
+        // These go in front of anything that was logged before the thread started.
+        if (numRestored > 0)
+            queuedRuns.push_front ({ true, numRestored });
+
+        numRestoredEventsQueued = numRestored;
+    }
+
+    //==============================================================================
+    // Sends the queued events as fast as possible, waiting until they've all gone
+    // or the timeout has passed. This is only for shutting down: it leaves the
+    // batch period at flushPeriodMs and the rest of the backlog in the log, as
+    // the analytics thread is stopped straight afterwards.
+    //
+    // It returns straight away if nothing is queued, or if the endpoint is down,
+    // in which case the events are being saved to disk instead.
+    void flush (int timeoutMs)
+    {
+        if (getNumEventsQueued() == 0)
+            return;
+
+        auto deadline = juce::Time::getMillisecondCounter() + (juce::uint32) juce::jmax (0, timeoutMs);
+
+        isFlushing = true;
+        setBatchPeriod (flushPeriodMs);
+
+        while (getNumEventsQueued() > 0 && ! circuitIsOpen)
+        {
+            auto remainingMs = (int) (deadline - juce::Time::getMillisecondCounter());
+
+            if (remainingMs <= 0)
+                break;
+
+            batchAttempted.wait (remainingMs);
+        }
+    }
 
-            for (auto& key : event.userProperties.getAllKeys())
-                userProperties->setAttribute (key, event.userProperties[key]);
+    void sendSucceeded (int numEventsSent)
+    {
+        consecutiveFailures = 0;
+
+        if (circuitIsOpen)
+        {
+            // The events moved to disk while the circuit was open are still in
+            // the log, and none of the ones restored from it are queued, so they
+            // can all be restored again from the oldest.
+            circuitIsOpen = false;
+            eventLog->rewind();
+        }
+
+        // Each batch that gets through halves the period, until it's back to
+        // the initial one.
+        backoffExponent = juce::jmax (0, backoffExponent - 1);
+        periodMs = getBackoffPeriod();
+
+        eventsDelivered (numEventsSent);
+    }
+
+    void sendFailed()
+    {
+        ++numBatchesRetried;
 
-            xmlEvent->addChildElement (userProperties);
+        // The period stops growing once it reaches the maximum, so that it
+        // takes only a few batches to ramp back up afterwards.
+        if (getBackoffPeriod() < getMaxBackoffPeriod())
+            ++backoffExponent;
 
-            xml->addChildElement (xmlEvent);                                                // [6]
+        // Half of the period is random, so that lots of clients that lost the
+        // endpoint at the same time don't all come back at once.
+        auto period = getBackoffPeriod();
+        periodMs = period - jitterRandom.nextInt (period / 2 + 1);
+
+        if (++consecutiveFailures >= failuresBeforeOpeningCircuit)
+        {
+            circuitIsOpen = true;
+            nextProbeTime = juce::Time::getMillisecondCounter() + (juce::uint32) periodMs;
         }
+    }
 
-        xml->writeTo (savedEventsFile);                                                     // [7]
+    int getBackoffPeriod() const
+    {
+        auto period = (juce::int64) initialPeriodMs << backoffExponent;
+        return (int) juce::jmin (period, (juce::int64) getMaxBackoffPeriod());
     }
 
-    void restoreUnloggedEvents (std::deque<AnalyticsEvent>& restoredEventQueue) override
+    int getMaxBackoffPeriod() const     { return juce::jmax (initialPeriodMs, maxBackoffPeriodMs); }
+
+    int millisecondsUntilProbe() const
     {
-        juce::XmlDocument savedEvents (savedEventsFile);
-        std::unique_ptr<juce::XmlElement> xml (savedEvents.getDocumentElement());           // [1]
+        return (int) (nextProbeTime - juce::Time::getMillisecondCounter());
+    }
 
-        if (xml.get() == nullptr || xml->getTagName() != "events")                          // [2]
+    // A probe is only sent once every event restored from the log has been moved
+    // to disk, or when the only ones queued are the probe batch, so that the log
+    // can be rewound if it succeeds.
+    bool isTimeToProbe() const
+    {
+        return millisecondsUntilProbe() <= 0 && (numRestoredEventsQueued == 0 || probeBatchIsQueued);
+    }
+
+    // Queues the oldest batch of events in the log again. The queue is empty, so
+    // they're the only restored events in it, and they'll be the first to be sent.
+    void queueProbeBatch()
+    {
+        eventLog->rewind();
+        probeBatchIsQueued = queueRestoredEvents (getMaximumBatchSize()) > 0;
+    }
+
+    // Takes a batch off the front of the queue without sending it. The events
+    // that were logged live are appended to the log, and the ones restored from
+    // it are already there.
+    void spillToDisk (const juce::Array<AnalyticsEvent>& events)
+    {
+        numEventsSpilled += events.size();
+
+        removeQueuedRuns (events.size(), [&] (bool isFromLog, int start, int numEvents)
+        {
+            if (isFromLog)
+                numRestoredEventsQueued -= numEvents;
+            else
+                eventLog->append (events.begin() + start, events.begin() + start + numEvents);
+        });
+    }
+
+    // Events are sent in the order they were queued, so a batch is always the
+    // events at the front of the queue.
+    void eventsDelivered (int numEventsSent)
+    {
+        auto numFromLog = 0;
+
+        removeQueuedRuns (numEventsSent, [&] (bool isFromLog, int, int numEvents)
+        {
+            if (isFromLog)
+                numFromLog += numEvents;
+        });
+
+        if (numFromLog > 0)
+        {
+            eventLog->acknowledge (numFromLog);
+            numRestoredEventsQueued -= numFromLog;
+        }
+
+        restoreMoreEvents();
+    }
+
+    // Tops the queue back up with the next events from the log. As this only
+    // replaces the ones that have just been sent, no more than a batch's worth are
+    // restored each period.
+    void restoreMoreEvents()
+    {
+        auto numToRestore = maxRestoredEventsQueued - numRestoredEventsQueued;
+
+        // While flushing, the rest of the backlog stays in the log, so that the
+        // queue can empty.
+        if (numToRestore <= 0 || isFlushing || eventLog->getNumEventsNotRestored() == 0)
             return;
 
-        auto numEvents = xml->getNumChildElements();
+        queueRestoredEvents (numToRestore);
+    }
+
+    int queueRestoredEvents (int maxNumEvents)
+    {
+        std::deque<AnalyticsEvent> restoredEvents;
+        auto numRestored = eventLog->restore (restoredEvents, maxNumEvents);
+
+        if (numRestored == 0)
+            return 0;
+
+        const juce::ScopedLock lock (queuedRunsLock);
+
+        addQueuedRun (true, numRestored);
+        numRestoredEventsQueued += numRestored;
 
-        for (auto iEvent = 0; iEvent < numEvents; ++iEvent)
+        for (auto& event : restoredEvents)
+            ThreadedAnalyticsDestination::logEvent (event);
+
+        return numRestored;
+    }
+
+    // Removes a batch from the front of queuedRuns, calling a function with the
+    // start and length of each part of it that came from the same place.
+    template <typename Callback>
+    void removeQueuedRuns (int numEvents, Callback&& callback)
+    {
+        const juce::ScopedLock lock (queuedRunsLock);
+
+        for (int start = 0; start < numEvents && ! queuedRuns.empty();)
         {
-            auto* xmlEvent = xml->getChildElement (iEvent);                                 // [3]
+            auto& run = queuedRuns.front();
+            auto numFromRun = juce::jmin (numEvents - start, run.numEvents);
 
-            juce::StringPairArray parameters;
-            auto* xmlParameters = xmlEvent->getChildByName ("parameters");                  // [4]
-            auto numParameters = xmlParameters->getNumAttributes();
+            callback (run.isFromLog, start, numFromRun);
 
-            for (auto iParam = 0; iParam < numParameters; ++iParam)
-                parameters.set (xmlParameters->getAttributeName (iParam),
-                                xmlParameters->getAttributeValue (iParam));
+            start += numFromRun;
+            run.numEvents -= numFromRun;
 
-            juce::StringPairArray userProperties;
-            auto* xmlUserProperties = xmlEvent->getChildByName ("user_properties");         // [5]
-            auto numUserProperties = xmlUserProperties->getNumAttributes();
+            if (run.numEvents == 0)
+                queuedRuns.pop_front();
+        }
+    }
 
-            for (auto iProp = 0; iProp < numUserProperties; ++iProp)
-                userProperties.set (xmlUserProperties->getAttributeName (iProp),
-                                    xmlUserProperties->getAttributeValue (iProp));
+    int getNumEventsQueued() const
+    {
+        const juce::ScopedLock lock (queuedRunsLock);
+
+        auto numEvents = 0;
+
+        for (auto& run : queuedRuns)
+            numEvents += run.numEvents;
+
+        return numEvents;
+    }
+
+    void addQueuedRun (bool isFromLog, int numEvents)
+    {
+        if (! queuedRuns.empty() && queuedRuns.back().isFromLog == isFromLog)
+            queuedRuns.back().numEvents += numEvents;
+        else
+            queuedRuns.push_back ({ isFromLog, numEvents });
+    }
+
+    // Events saved as XML by an older version of the app are moved into the log.
+    void migrateLegacyEvents()
+    {
+        if (! legacyEventsFile.existsAsFile())
+            return;
+
+        std::deque<AnalyticsEvent> legacyEvents;
+        restoreLegacyEvents (legacyEvents);
+
+        if (eventLog->append (legacyEvents.begin(), legacyEvents.end()))
+            legacyEventsFile.deleteFile();
+    }
+
+    void restoreLegacyEvents (std::deque<AnalyticsEvent>& restoredEventQueue)
+    {
+        juce::XmlDocument savedEvents (legacyEventsFile);
+        std::unique_ptr<juce::XmlElement> xml (savedEvents.getDocumentElement());           // [1]
+
+        if (xml.get() == nullptr || xml->getTagName() != "events")                          // [2]
+            return;
+
+        auto readAttributes = [] (const juce::XmlElement* element)
+        {
+            juce::StringPairArray attributes;
+
+            if (element != nullptr)
+                for (auto i = 0; i < element->getNumAttributes(); ++i)
+                    attributes.set (element->getAttributeName (i), element->getAttributeValue (i));
+
+            return attributes;
+        };
+
+        for (auto iEvent = 0; iEvent < xml->getNumChildElements(); ++iEvent)
+        {
+            auto* xmlEvent = xml->getChildElement (iEvent);                                 // [3]
 
             restoredEventQueue.push_back ({
                 xmlEvent->getStringAttribute ("name"),                                      // [6]
                 xmlEvent->getIntAttribute ("type"),
                 static_cast<juce::uint32> (xmlEvent->getIntAttribute ("timestamp")),
-                parameters,
+                readAttributes (xmlEvent->getChildByName ("parameters")),                   // [4]
                 xmlEvent->getStringAttribute ("user_id"),
-                userProperties
+                readAttributes (xmlEvent->getChildByName ("user_properties"))               // [5]
             });
         }
-
-        savedEventsFile.deleteFile();                                                       // [7]
     }
 
-    const int initialPeriodMs = 1000;
+    const int initialPeriodMs;
     int periodMs = initialPeriodMs;
 
+    // The backoff and circuit breaker are only used on the analytics thread.
+    static constexpr int maxBackoffPeriodMs = 5000;
+    static constexpr int failuresBeforeOpeningCircuit = 3;
+    static constexpr int spillPeriodMs = 10;
+
+    int backoffExponent = 0, consecutiveFailures = 0;
+    std::atomic<bool> circuitIsOpen { false };
+    std::atomic<int> numBatchesRetried { 0 }, numEventsSpilled { 0 };
+    juce::uint32 nextProbeTime = 0;
+    bool probeBatchIsQueued = false;
+    juce::Random jitterRandom;
+
+    // While flushing, batches are sent one straight after another. A period of
+    // 0 would make the analytics thread spin once the queue is empty.
+    static constexpr int flushPeriodMs = 1;
+    std::atomic<bool> isFlushing { false };
+    juce::WaitableEvent batchAttempted;
+    int shutdownFlushTimeoutMs = 1000;
+
     juce::CriticalSection webStreamCreation;
     bool shouldExit = false;
     std::unique_ptr<juce::WebInputStream> webStream;
 
+    juce::URL endpoint;
     juce::String apiKey;
+    std::unique_ptr<AnalyticsPayloadEncoder> encoder;     // only used on the analytics thread
+
+    std::unique_ptr<AnalyticsEventLog> eventLog;
+    juce::File legacyEventsFile;
+
+    // Which of the queued events came from the log, as runs of consecutive events
+    // with the same origin, oldest first.
+    struct QueuedRun
+    {
+        bool isFromLog;
+        int numEvents;
+    };
 
-    juce::File savedEventsFile;
+    juce::CriticalSection queuedRunsLock;
+    std::deque<QueuedRun> queuedRuns;
+
+    static constexpr int maxRestoredEventsQueued = 100;
+    int numRestoredEventsQueued = 0;    // only used on the analytics thread, or once it's stopped
 };
 
 //==============================================================================
@@ -315,7 +631,14 @@ public:
         juce::Analytics::getInstance()->setUserProperties (userData);                               // [2]
 
         // Add any analytics destinations we want to use to the Analytics singleton.
-        juce::Analytics::getInstance()->addDestination (new GoogleAnalyticsDestination());          // [3]
+        auto* destination = new GoogleAnalyticsDestination();
+        juce::Analytics::getInstance()->addDestination (destination);                               // [3]
+
+        // Events logged from the audio thread go straight to the destination,
+        // through a logger that never allocates or locks.
+        audioThreadAnalytics.reset (new RealtimeAnalyticsLogger (*destination, "AnonUser1234", userData));
+        overloadEvent = audioThreadAnalytics->addEventType ("audio_overload", DemoAnalyticsEventTypes::event,
+                                                            { "block_size" });
 
         // The event type here should probably be DemoAnalyticsEventTypes::sessionStart
         // in a more advanced app.
@@ -323,8 +646,13 @@ public:
 
         crashButton.onClick = [this] { sendCrash(); };
 
+        // In a plug-in this would be called from processBlock when the block
+        // takes too long to process.
+        overloadButton.onClick = [this] { audioThreadAnalytics->logEvent (overloadEvent, { 512.0f }); };
+
         addAndMakeVisible (eventButton);
         addAndMakeVisible (crashButton);
+        addAndMakeVisible (overloadButton);
 
         setSize (300, 200);
 
@@ -350,6 +678,7 @@ public:
         eventButton.centreWithSize (100, 40);
         eventButton.setBounds (eventButton.getBounds().translated (0, 25));
         crashButton.setBounds (eventButton.getBounds().translated (0, -50));
+        overloadButton.setBounds (eventButton.getBounds().translated (0, 50));
     }
 
 private:
@@ -359,12 +688,16 @@ private:
         // In a more advanced application you would probably use a different event
         // type here.
         juce::Analytics::getInstance()->logEvent ("crash", {}, DemoAnalyticsEventTypes::event);
+        audioThreadAnalytics.reset();   // this sends to a destination that's about to be deleted
         juce::Analytics::getInstance()->getDestinations().clear();
         juce::JUCEApplication::getInstance()->quit();
     }
 
-    juce::TextButton eventButton { "Press me!" }, crashButton { "Simulate crash!" };
+    juce::TextButton eventButton { "Press me!" }, crashButton { "Simulate crash!" }, overloadButton { "Simulate overload!" };
     std::unique_ptr<juce::ButtonTracker> logEventButtonPress;   // [1]
 
+    std::unique_ptr<RealtimeAnalyticsLogger> audioThreadAnalytics;
+    int overloadEvent = 0;
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MainContentComponent)
 };
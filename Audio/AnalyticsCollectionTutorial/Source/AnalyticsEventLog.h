@@ -0,0 +1,452 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE tutorials.
+   Copyright (c) 2020 - Raw Material Software Limited
+
+   The code included in this file is provided under the terms of the ISC license
+   http://www.isc.org/downloads/software-support-policy/isc-license. Permission
+   To use, copy, modify, and/or distribute this software for any purpose with or
+   without fee is hereby granted provided that the above copyright notice and
+   this permission notice appear in all copies.
+
+   THE SOFTWARE IS PROVIDED "AS IS" WITHOUT ANY WARRANTY, AND ALL WARRANTIES,
+   WHETHER EXPRESSED OR IMPLIED, INCLUDING MERCHANTABILITY AND FITNESS FOR
+   PURPOSE, ARE DISCLAIMED.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+
+//==============================================================================
+/**
+    An append-only log of analytics events that haven't been delivered yet.
+
+    Every record is written as its length, a CRC-32 of its contents and then the
+    contents, so adding events never reads or rewrites what's already there, and
+    the cost of saving doesn't grow with the size of the backlog.
+
+    Delivered events aren't removed straight away. Instead a small record is
+    appended which acknowledges the oldest ones, and when everything in the log
+    has been acknowledged it is emptied, or when most of it has, the remaining
+    events are copied into a new log which replaces the old one.
+
+    Events are restored a few at a time, carrying on from where the last lot
+    finished. Opening the log only counts its records, so a large backlog costs
+    a quick pass over the file rather than memory for every event in it.
+
+    If the app dies part-way through writing, the record at the end is left torn.
+    When the log is opened, it is read up to the last complete record that has a
+    matching checksum, and anything after that is cut off.
+*/
+class AnalyticsEventLog
+{
+public:
+    using AnalyticsEvent = juce::AnalyticsDestination::AnalyticsEvent;
+
+    explicit AnalyticsEventLog (const juce::File& fileToUse)
+        : file (fileToUse)
+    {
+    }
+
+    const juce::File& getFile() const noexcept      { return file; }
+
+    /** Adds up to maxNumEvents of the unacknowledged events that haven't been
+        restored yet to the end of a queue, oldest first, and returns how many
+        were added. The log is opened if it isn't open yet.
+    */
+    int restore (std::deque<AnalyticsEvent>& restoredEvents, int maxNumEvents)
+    {
+        openForReading();
+
+        auto numToRestore = juce::jmin (maxNumEvents, getNumEventsNotRestored());
+
+        if (numToRestore <= 0)
+            return 0;
+
+        juce::FileInputStream fileStream (file);
+
+        if (fileStream.failedToOpen())
+            return 0;
+
+        juce::BufferedInputStream input (fileStream, bufferSize);
+
+        // If the log has been compacted since the last lot, the events that were
+        // restored before it have to be skipped again.
+        auto numToSkip = readPosition > 0 ? 0 : numRestored;
+
+        if (! input.setPosition (readPosition > 0 ? readPosition : headerSize))
+            return 0;
+
+        juce::MemoryBlock record;
+        auto numAdded = 0;
+
+        while (numAdded < numToRestore && readRecord (input, record))
+        {
+            juce::MemoryInputStream recordStream (record, false);
+
+            if (recordStream.readByte() != eventRecord)
+                continue;
+
+            if (numToSkip > 0)
+            {
+                --numToSkip;
+            }
+            else
+            {
+                restoredEvents.push_back (readEvent (recordStream));
+                ++numAdded;
+            }
+
+            readPosition = input.getPosition();
+        }
+
+        numRestored += numAdded;
+        return numAdded;
+    }
+
+    /** Appends some events to the end of the log. Returns false if they couldn't
+        be written.
+    */
+    template <typename Iterator>
+    bool append (Iterator begin, Iterator end)
+    {
+        if (! openForAppending())
+            return false;
+
+        juce::MemoryOutputStream record;
+
+        for (auto it = begin; it != end; ++it)
+        {
+            record.reset();
+            record.writeByte ((char) eventRecord);
+            writeEvent (record, *it);
+
+            if (! writeRecord (*output, record.getData(), record.getDataSize()))
+                return false;
+
+            ++numEvents;
+        }
+
+        return flush();
+    }
+
+    /** Records that the oldest few events in the log have been delivered, and
+        compacts the log if that leaves enough of it unused.
+    */
+    void acknowledge (int numEventsDelivered)
+    {
+        if (numEventsDelivered <= 0 || ! openForAppending())
+            return;
+
+        numEventsDelivered = juce::jmin (numEventsDelivered, getNumUnacknowledgedEvents());
+
+        if (numEventsDelivered == 0)
+            return;
+
+        juce::MemoryOutputStream record;
+        record.writeByte ((char) acknowledgementRecord);
+        record.writeCompressedInt (numEventsDelivered);
+
+        if (! (writeRecord (*output, record.getData(), record.getDataSize()) && flush()))
+            return;
+
+        numAcknowledged += numEventsDelivered;
+        numRestored = juce::jmax (numRestored, numAcknowledged);
+
+        if (numAcknowledged == numEvents)
+            clear();
+        else if (numAcknowledged >= numEvents / 2 && output->getPosition() > minimumSizeToCompact)
+            compact();
+    }
+
+    /** Makes the next restore() start again from the oldest unacknowledged
+        event, for when the restored events have been dropped without being sent.
+    */
+    void rewind() noexcept
+    {
+        numRestored = numAcknowledged;
+        readPosition = 0;
+    }
+
+    int getNumUnacknowledgedEvents() const noexcept     { return numEvents - numAcknowledged; }
+    int getNumEventsNotRestored() const noexcept        { return numEvents - numRestored; }
+
+    /** Empties the log. */
+    void clear()
+    {
+        output.reset();
+        file.deleteFile();
+        numEvents = numAcknowledged = numRestored = 0;
+        readPosition = 0;
+        hasBeenScanned = true;
+    }
+
+private:
+    //==============================================================================
+    enum RecordType
+    {
+        eventRecord = 1,
+        acknowledgementRecord = 2
+    };
+
+    static constexpr int fileMagic = 0x314c4541;     // "AEL1"
+    static constexpr int headerSize = 4;
+    static constexpr int recordHeaderSize = 8;
+    static constexpr int maximumRecordSize = 16 * 1024 * 1024;
+    static constexpr int bufferSize = 65536;
+    static constexpr juce::int64 minimumSizeToCompact = 64 * 1024;
+
+    //==============================================================================
+    void openForReading()
+    {
+        if (! hasBeenScanned)
+        {
+            scan();
+            hasBeenScanned = true;
+        }
+    }
+
+    bool openForAppending()
+    {
+        if (output != nullptr)
+            return true;
+
+        openForReading();
+
+        output.reset (new juce::FileOutputStream (file));
+
+        if (output->failedToOpen())
+        {
+            output.reset();
+            return false;
+        }
+
+        if (output->getPosition() == 0)
+            output->writeInt (fileMagic);
+
+        return true;
+    }
+
+    // Counts the events and acknowledgements in the log without decoding any of
+    // the events. Anything after the last good record is cut off.
+    void scan()
+    {
+        numEvents = numAcknowledged = numRestored = 0;
+        readPosition = 0;
+
+        juce::int64 validSize = 0;
+
+        {
+            juce::FileInputStream fileStream (file);
+
+            if (fileStream.failedToOpen())
+                return;
+
+            juce::BufferedInputStream input (fileStream, bufferSize);
+
+            if (input.readInt() == fileMagic)
+            {
+                validSize = headerSize;
+                juce::MemoryBlock record;
+
+                while (readRecord (input, record))
+                {
+                    juce::MemoryInputStream recordStream (record, false);
+                    auto type = recordStream.readByte();
+
+                    if (type == eventRecord)
+                        ++numEvents;
+                    else if (type == acknowledgementRecord)
+                        numAcknowledged += juce::jmin (recordStream.readCompressedInt(), getNumUnacknowledgedEvents());
+
+                    validSize = input.getPosition();
+                }
+            }
+
+            numRestored = numAcknowledged;
+
+            if (validSize == input.getTotalLength())
+                return;
+        }
+
+        // Cut off the torn or corrupt tail, so that new records can follow the good ones.
+        juce::FileOutputStream out (file);
+
+        if (out.openedOk() && out.setPosition (validSize))
+            out.truncate();
+    }
+
+    static bool readRecord (juce::InputStream& input, juce::MemoryBlock& record)
+    {
+        if (input.getNumBytesRemaining() < recordHeaderSize)
+            return false;
+
+        auto size = input.readInt();
+        auto checksum = (juce::uint32) input.readInt();
+
+        if (size <= 0 || size > maximumRecordSize || input.getNumBytesRemaining() < size)
+            return false;
+
+        record.setSize ((size_t) size, false);
+
+        return input.read (record.getData(), size) == size
+                && calculateCRC32 (record.getData(), (size_t) size) == checksum;
+    }
+
+    static bool writeRecord (juce::OutputStream& out, const void* data, size_t size)
+    {
+        return out.writeInt ((int) size)
+                && out.writeInt ((int) calculateCRC32 (data, size))
+                && out.write (data, size);
+    }
+
+    bool flush()
+    {
+        output->flush();
+        return output->getStatus().wasOk();
+    }
+
+    // Copies the records of the unacknowledged events into a new log, which then
+    // replaces this one. The events aren't decoded, so this needs no more memory
+    // however many of them there are.
+    void compact()
+    {
+        output.reset();
+
+        juce::TemporaryFile tempFile (file);
+
+        {
+            juce::FileInputStream fileStream (file);
+            juce::FileOutputStream out (tempFile.getFile());
+
+            if (fileStream.failedToOpen() || out.failedToOpen())
+                return;
+
+            juce::BufferedInputStream input (fileStream, bufferSize);
+
+            if (! (input.setPosition (headerSize) && out.writeInt (fileMagic)))
+                return;
+
+            juce::MemoryBlock record;
+            auto numToSkip = numAcknowledged;
+
+            while (readRecord (input, record))
+            {
+                if (record[0] != eventRecord)
+                    continue;
+
+                if (numToSkip > 0)
+                    --numToSkip;
+                else if (! writeRecord (out, record.getData(), record.getSize()))
+                    return;
+            }
+
+            out.flush();
+
+            if (out.getStatus().failed())
+                return;
+        }
+
+        if (tempFile.overwriteTargetFileWithTemporary())
+        {
+            numEvents -= numAcknowledged;
+            numRestored -= numAcknowledged;
+            numAcknowledged = 0;
+            readPosition = 0;
+        }
+    }
+
+    //==============================================================================
+    static void writeEvent (juce::OutputStream& out, const AnalyticsEvent& event)
+    {
+        out.writeString (event.name);
+        out.writeInt (event.eventType);
+        out.writeInt ((int) event.timestamp);
+        out.writeString (event.userID);
+        writeStringPairs (out, event.parameters);
+        writeStringPairs (out, event.userProperties);
+    }
+
+    static AnalyticsEvent readEvent (juce::InputStream& in)
+    {
+        auto name = in.readString();
+        auto eventType = in.readInt();
+        auto timestamp = (juce::uint32) in.readInt();
+        auto userID = in.readString();
+        auto parameters = readStringPairs (in);
+        auto userProperties = readStringPairs (in);
+
+        return { name, eventType, timestamp, parameters, userID, userProperties };
+    }
+
+    static void writeStringPairs (juce::OutputStream& out, const juce::StringPairArray& pairs)
+    {
+        auto& keys = pairs.getAllKeys();
+        auto& values = pairs.getAllValues();
+
+        out.writeCompressedInt (keys.size());
+
+        for (int i = 0; i < keys.size(); ++i)
+        {
+            out.writeString (keys[i]);
+            out.writeString (values[i]);
+        }
+    }
+
+    static juce::StringPairArray readStringPairs (juce::InputStream& in)
+    {
+        juce::StringPairArray pairs;
+
+        for (auto i = in.readCompressedInt(); i > 0 && ! in.isExhausted(); --i)
+        {
+            auto key = in.readString();
+            pairs.set (key, in.readString());
+        }
+
+        return pairs;
+    }
+
+    //==============================================================================
+    static juce::uint32 calculateCRC32 (const void* data, size_t numBytes) noexcept
+    {
+        static const auto table = []
+        {
+            std::array<juce::uint32, 256> t;
+
+            for (juce::uint32 i = 0; i < 256; ++i)
+            {
+                auto c = i;
+
+                for (int bit = 0; bit < 8; ++bit)
+                    c = (c & 1) != 0 ? 0xedb88320u ^ (c >> 1) : c >> 1;
+
+                t[i] = c;
+            }
+
+            return t;
+        }();
+
+        auto crc = 0xffffffffu;
+
+        for (auto* p = static_cast<const juce::uint8*> (data); numBytes > 0; ++p, --numBytes)
+            crc = table[(crc ^ *p) & 0xff] ^ (crc >> 8);
+
+        return crc ^ 0xffffffffu;
+    }
+
+    //==============================================================================
+    juce::File file;
+    std::unique_ptr<juce::FileOutputStream> output;
+    bool hasBeenScanned = false;
+
+    // numRestored counts the events at the start of the log that have been either
+    // restored or acknowledged, and readPosition is where the next one starts, or
+    // 0 if that isn't known.
+    int numEvents = 0, numAcknowledged = 0, numRestored = 0;
+    juce::int64 readPosition = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AnalyticsEventLog)
+};
@@ -0,0 +1,219 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE tutorials.
+   Copyright (c) 2020 - Raw Material Software Limited
+
+   The code included in this file is provided under the terms of the ISC license
+   http://www.isc.org/downloads/software-support-policy/isc-license. Permission
+   To use, copy, modify, and/or distribute this software for any purpose with or
+   without fee is hereby granted provided that the above copyright notice and
+   this permission notice appear in all copies.
+
+   THE SOFTWARE IS PROVIDED "AS IS" WITHOUT ANY WARRANTY, AND ALL WARRANTIES,
+   WHETHER EXPRESSED OR IMPLIED, INCLUDING MERCHANTABILITY AND FITNESS FOR
+   PURPOSE, ARE DISCLAIMED.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+//==============================================================================
+/**
+    Writes batches of analytics events in the Google Analytics measurement
+    protocol format: one URL-encoded hit per line.
+
+    Everything that's the same for every hit is escaped once, up front: the
+    version and tracking ID that start each hit, and, for each event name added
+    with addEventMapping(), the fields it's sent with. Encoding an event then
+    looks its name up, copies those bytes, and only escapes the values that come
+    from the event itself - its parameters and user ID.
+
+    The hits are written into one buffer, which is kept from batch to batch, so
+    once it has grown to the size of a batch, encoding doesn't allocate.
+
+    The escaping matches juce::URL::addEscapeChars (text, true), so the payload
+    is the same byte for byte as one built from StringPairArrays.
+*/
+class AnalyticsPayloadEncoder
+{
+public:
+    using AnalyticsEvent = juce::AnalyticsDestination::AnalyticsEvent;
+
+    explicit AnalyticsPayloadEncoder (const juce::String& apiKey)
+    {
+        juce::MemoryOutputStream out (hitPrefix, false);
+        out << "v=1&aip=1&tid=";
+        writeEscaped (out, apiKey);
+        out << "&";
+    }
+
+    /** Says how to send events with a given name. The fields are sent in order,
+        followed by a field for each of fieldsFromParameters, whose value is the
+        event parameter named by the value of the entry. If valuePrefixes has an
+        entry for one of those fields, its text comes before the parameter's value.
+    */
+    void addEventMapping (const juce::String& eventName,
+                          const juce::StringPairArray& fields,
+                          const juce::StringPairArray& fieldsFromParameters = {},
+                          const juce::StringPairArray& valuePrefixes = {})
+    {
+        jassert (fields.size() > 0);
+
+        Mapping mapping;
+
+        {
+            juce::MemoryOutputStream out (mapping.fields, false);
+
+            for (int i = 0; i < fields.size(); ++i)
+                writeField (out, i > 0, fields.getAllKeys()[i], fields.getAllValues()[i]);
+        }
+
+        for (int i = 0; i < fieldsFromParameters.size(); ++i)
+        {
+            auto key = fieldsFromParameters.getAllKeys()[i];
+
+            FieldFromParameter field;
+            field.parameterName = fieldsFromParameters.getAllValues()[i];
+
+            juce::MemoryOutputStream out (field.prefix, false);
+            writeField (out, true, key, valuePrefixes[key]);
+
+            mapping.fieldsFromParameters.push_back (field);
+        }
+
+        mappings.push_back (mapping);
+        mappingIndices.set (eventName, (int) mappings.size());
+    }
+
+    /** Clears the batch, but keeps its memory for the next one. */
+    void startBatch()
+    {
+        batch.reset();
+        numEvents = 0;
+    }
+
+    /** Adds an event to the batch. Returns false, and leaves the batch alone, if
+        no mapping has been added for the event's name.
+    */
+    bool addEvent (const AnalyticsEvent& event)
+    {
+        auto index = mappingIndices[event.name] - 1;
+
+        if (index < 0)
+            return false;
+
+        auto& mapping = mappings[(size_t) index];
+
+        if (numEvents > 0)
+            batch.writeByte ('\n');
+
+        write (hitPrefix);
+        write (mapping.fields);
+
+        for (auto& field : mapping.fieldsFromParameters)
+        {
+            write (field.prefix);
+            writeEscaped (batch, event.parameters[field.parameterName]);
+        }
+
+        if (event.userID != userID || userIDField.isEmpty())
+        {
+            userID = event.userID;
+            userIDField.reset();
+
+            juce::MemoryOutputStream out (userIDField, false);
+            writeField (out, true, "cid", userID);
+        }
+
+        write (userIDField);
+
+        ++numEvents;
+        return true;
+    }
+
+    int getNumEvents() const noexcept                   { return numEvents; }
+    const void* getData() const noexcept                { return batch.getData(); }
+    size_t getDataSize() const noexcept                 { return batch.getDataSize(); }
+
+    /** Returns a copy of the batch, for passing to juce::URL::withPOSTData(). */
+    juce::MemoryBlock getBatch() const                  { return batch.getMemoryBlock(); }
+
+    //==============================================================================
+    /** Writes text with every byte that isn't a letter, a digit or one of _-.~()
+        written as %XX, like juce::URL::addEscapeChars (text, true).
+    */
+    static void writeEscaped (juce::OutputStream& out, const juce::String& text)
+    {
+        auto* runStart = text.toRawUTF8();
+        auto* p = runStart;
+
+        for (;; ++p)
+        {
+            auto c = (juce::uint8) *p;
+
+            if (c == 0)
+                break;
+
+            if (isUnreserved (c))
+                continue;
+
+            const char escaped[] = { '%', "0123456789ABCDEF"[c >> 4], "0123456789ABCDEF"[c & 15] };
+
+            out.write (runStart, (size_t) (p - runStart));
+            out.write (escaped, sizeof (escaped));
+            runStart = p + 1;
+        }
+
+        out.write (runStart, (size_t) (p - runStart));
+    }
+
+private:
+    //==============================================================================
+    struct FieldFromParameter
+    {
+        juce::MemoryBlock prefix;       // "&key=" and any escaped value prefix
+        juce::String parameterName;
+    };
+
+    struct Mapping
+    {
+        juce::MemoryBlock fields;       // "t=event&ec=info&ea=appStarted"
+        std::vector<FieldFromParameter> fieldsFromParameters;
+    };
+
+    static bool isUnreserved (juce::uint8 c) noexcept
+    {
+        return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9')
+                || c == '_' || c == '-' || c == '.' || c == '~' || c == '(' || c == ')';
+    }
+
+    static void writeField (juce::OutputStream& out, bool needsSeparator, const juce::String& key, const juce::String& value)
+    {
+        if (needsSeparator)
+            out.writeByte ('&');
+
+        writeEscaped (out, key);
+        out.writeByte ('=');
+        writeEscaped (out, value);
+    }
+
+    void write (const juce::MemoryBlock& bytes)
+    {
+        batch.write (bytes.getData(), bytes.getSize());
+    }
+
+    //==============================================================================
+    juce::MemoryBlock hitPrefix;        // "v=1&aip=1&tid=UA-XXXXXXXXX-1&"
+    std::vector<Mapping> mappings;
+    juce::HashMap<juce::String, int> mappingIndices;    // one more than the index into mappings
+
+    juce::String userID;
+    juce::MemoryBlock userIDField;      // "&cid=AnonUser1234"
+
+    juce::MemoryOutputStream batch { 8192 };
+    int numEvents = 0;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (AnalyticsPayloadEncoder)
+};
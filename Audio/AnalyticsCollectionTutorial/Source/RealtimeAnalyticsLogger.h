@@ -0,0 +1,243 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE tutorials.
+   Copyright (c) 2020 - Raw Material Software Limited
+
+   The code included in this file is provided under the terms of the ISC license
+   http://www.isc.org/downloads/software-support-policy/isc-license. Permission
+   To use, copy, modify, and/or distribute this software for any purpose with or
+   without fee is hereby granted provided that the above copyright notice and
+   this permission notice appear in all copies.
+
+   THE SOFTWARE IS PROVIDED "AS IS" WITHOUT ANY WARRANTY, AND ALL WARRANTIES,
+   WHETHER EXPRESSED OR IMPLIED, INCLUDING MERCHANTABILITY AND FITNESS FOR
+   PURPOSE, ARE DISCLAIMED.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+//==============================================================================
+/**
+    Logs analytics events from the audio thread.
+
+    juce::Analytics::logEvent builds StringPairArrays and takes locks, so it
+    mustn't be called from processBlock. Instead, the kinds of event to log are
+    added up front with addEventType(), and logEvent() just writes a small
+    fixed-size record - the event's index, a timestamp and a few numbers - into a
+    preallocated ring. It never allocates, locks or waits, so any number of audio
+    threads can call it at once.
+
+    A background thread empties the ring every few milliseconds. It turns each
+    record into an AnalyticsEvent with the parameter names given to addEventType(),
+    and passes it to the destination.
+
+    If the ring fills up because the background thread can't keep up, new events
+    are dropped and counted rather than blocking the audio thread.
+
+    @code
+    overloadEvent = logger.addEventType ("audio_overload", DemoAnalyticsEventTypes::event, { "block_size" });
+
+    void processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer&) override
+    {
+        ...
+        if (overloaded)
+            logger.logEvent (overloadEvent, { (float) buffer.getNumSamples() });
+    }
+    @endcode
+*/
+class RealtimeAnalyticsLogger  : private juce::Thread
+{
+public:
+    using AnalyticsEvent = juce::AnalyticsDestination::AnalyticsEvent;
+
+    static constexpr int maxNumValues = 4;
+
+    /** Creates a logger which sends events to a destination. The destination
+        must outlive the logger, and the events are sent with the given user ID
+        and properties.
+    */
+    RealtimeAnalyticsLogger (juce::AnalyticsDestination& destinationToUse,
+                             const juce::String& userIDToUse,
+                             const juce::StringPairArray& userPropertiesToUse,
+                             int ringSizePowerOfTwo = 12)
+        : juce::Thread ("RealtimeAnalyticsLogger"),
+          destination (destinationToUse),
+          userID (userIDToUse),
+          userProperties (userPropertiesToUse),
+          ringSize ((juce::uint32) 1 << ringSizePowerOfTwo),
+          slots (new Slot[ringSize])
+    {
+        for (juce::uint32 i = 0; i < ringSize; ++i)
+            slots[i].sequence.store (i, std::memory_order_relaxed);
+
+        startThread();
+    }
+
+    ~RealtimeAnalyticsLogger() override
+    {
+        stopThread (stopTimeoutMs);
+        sendQueuedEvents();
+    }
+
+    /** Adds a kind of event that can be logged, and returns the index to pass to
+        logEvent(). Each number logged with the event is sent as a parameter with
+        the matching name.
+
+        Event types have to be added before any thread starts logging events.
+    */
+    int addEventType (const juce::String& name, int eventType, const juce::StringArray& parameterNames = {})
+    {
+        jassert (parameterNames.size() <= maxNumValues);
+
+        eventTypes.add ({ name, eventType, parameterNames });
+        return eventTypes.size() - 1;
+    }
+
+    /** Queues an event to be sent. This is safe to call from the audio thread, or
+        from several at once.
+
+        Returns false if the event had to be dropped because the queue was full.
+    */
+    bool logEvent (int eventTypeIndex, std::initializer_list<float> values = {}) noexcept
+    {
+        jassert (juce::isPositiveAndBelow (eventTypeIndex, eventTypes.size()));
+        jassert (values.size() <= (size_t) maxNumValues);
+
+        Record record;
+        record.eventTypeIndex = eventTypeIndex;
+        record.timestamp = juce::Time::getMillisecondCounter();
+        record.numValues = (int) juce::jmin (values.size(), (size_t) maxNumValues);
+        std::copy (values.begin(), values.begin() + record.numValues, record.values);
+
+        if (push (record))
+            return true;
+
+        numDroppedEvents.fetch_add (1, std::memory_order_relaxed);
+        return false;
+    }
+
+    /** Returns the number of events dropped because the queue was full. */
+    juce::uint32 getNumDroppedEvents() const noexcept   { return numDroppedEvents.load (std::memory_order_relaxed); }
+
+private:
+    //==============================================================================
+    struct EventType
+    {
+        juce::String name;
+        int eventType;
+        juce::StringArray parameterNames;
+    };
+
+    struct Record
+    {
+        int eventTypeIndex;
+        juce::uint32 timestamp;
+        int numValues;
+        float values[maxNumValues];
+    };
+
+    // Each slot's sequence number says whose turn it is: a slot can be written
+    // when its number equals the write position, and read when it's one more
+    // than the read position.
+    struct Slot
+    {
+        std::atomic<juce::uint32> sequence { 0 };
+        Record record;
+    };
+
+    static constexpr int pollIntervalMs = 50;
+    static constexpr int stopTimeoutMs = 2000;
+
+    //==============================================================================
+    bool push (const Record& record) noexcept
+    {
+        auto position = writePosition.load (std::memory_order_relaxed);
+
+        for (;;)
+        {
+            auto& slot = slots[position & (ringSize - 1)];
+            auto difference = (juce::int32) (slot.sequence.load (std::memory_order_acquire) - position);
+
+            if (difference == 0)
+            {
+                if (writePosition.compare_exchange_weak (position, position + 1, std::memory_order_relaxed))
+                {
+                    slot.record = record;
+                    slot.sequence.store (position + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (difference < 0)
+            {
+                return false;   // the reader hasn't emptied this slot yet, so the ring is full
+            }
+            else
+            {
+                position = writePosition.load (std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool pop (Record& record) noexcept
+    {
+        auto& slot = slots[readPosition & (ringSize - 1)];
+
+        if (slot.sequence.load (std::memory_order_acquire) != readPosition + 1)
+            return false;
+
+        record = slot.record;
+        slot.sequence.store (readPosition + ringSize, std::memory_order_release);
+        ++readPosition;
+        return true;
+    }
+
+    //==============================================================================
+    void run() override
+    {
+        // The audio thread can't wake us up without risking a lock, so we poll.
+        while (! threadShouldExit())
+        {
+            sendQueuedEvents();
+            wait (pollIntervalMs);
+        }
+    }
+
+    void sendQueuedEvents()
+    {
+        Record record;
+
+        while (pop (record))
+        {
+            auto& type = eventTypes.getReference (record.eventTypeIndex);
+            juce::StringPairArray parameters;
+
+            for (int i = 0; i < record.numValues; ++i)
+                parameters.set (type.parameterNames[i], formatValue (record.values[i]));
+
+            destination.logEvent ({ type.name, type.eventType, record.timestamp, parameters, userID, userProperties });
+        }
+    }
+
+    static juce::String formatValue (float value)
+    {
+        auto rounded = juce::roundToInt (value);
+        return (float) rounded == value ? juce::String (rounded) : juce::String (value);
+    }
+
+    //==============================================================================
+    juce::AnalyticsDestination& destination;
+    const juce::String userID;
+    const juce::StringPairArray userProperties;
+    juce::Array<EventType> eventTypes;
+
+    const juce::uint32 ringSize;
+    std::unique_ptr<Slot[]> slots;
+    std::atomic<juce::uint32> writePosition { 0 };
+    juce::uint32 readPosition = 0;      // only used by the background thread
+    std::atomic<juce::uint32> numDroppedEvents { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (RealtimeAnalyticsLogger)
+};
@@ -0,0 +1,689 @@
+/*
+  ==============================================================================
+
+    Headless benchmark for the file loading done by FileReadingTutorial.
+
+    Runs the loading strategy of each tutorial step's readFile() (without the
+    TextEditor, which needs a GUI) alongside the faster paths used by the
+    TextFileView in _05, over generated corpora of different shapes and sizes.
+    Each run reports its throughput, the peak resident memory and the number of
+    heap allocations it made. Exits with an error if a tokeniser allocates per
+    word.
+
+    Before that, TextLineDiff is checked against a plain LCS on a few thousand
+    random pairs of line lists, small enough for it to diff exactly. Every diff
+    has to be valid and as short as the LCS allows, or the benchmark fails.
+    Usage:
+
+        FileReadingBenchmark [--sizes=1K,1M,100M,1G] [--corpora=words,longlines,utf8]
+
+    Sizes can end in K, M or G, and plain numbers are taken as MB, so --sizes=4G
+    runs the largest corpus. The variants that load the whole file into a String
+    are skipped for corpora over 512 MB, and the gzip variant for ones over
+    256 MB, as compressing the corpus takes longer than the benchmark.
+
+    On Linux the peak resident memory is reset before each run, so it belongs to
+    that run alone. Elsewhere, or if it can't be reset, it's the peak for the
+    process so far, and is reported as "peak since start". Mapped variants count
+    the pages of the file they've touched.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../../FileReadingTutorial/Source/TextScanner.h"
+#include "../../FileReadingTutorial/Source/TextTokenizer.h"
+#include "../../FileReadingTutorial/Source/TextLineIndex.h"
+#include "../../FileReadingTutorial/Source/TextSearch.h"
+#include "../../FileReadingTutorial/Source/CompressedTextSource.h"
+#include "../../FileReadingTutorial/Source/TextLineDiff.h"
+
+#if JUCE_WINDOWS
+ #include <windows.h>
+ #include <psapi.h>
+ #pragma comment (lib, "psapi.lib")
+#else
+ #include <sys/resource.h>
+ #include <fcntl.h>
+ #include <unistd.h>
+#endif
+
+//==============================================================================
+// Every heap allocation in the process goes through here so that each benchmark
+// can report how many it made.
+static std::atomic<juce::int64> numAllocations { 0 };
+
+void* operator new (std::size_t size)
+{
+    ++numAllocations;
+
+    if (auto* p = std::malloc (size == 0 ? 1 : size))
+        return p;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[] (std::size_t size)                  { return operator new (size); }
+void operator delete (void* p) noexcept                  { std::free (p); }
+void operator delete[] (void* p) noexcept                { std::free (p); }
+void operator delete (void* p, std::size_t) noexcept     { std::free (p); }
+void operator delete[] (void* p, std::size_t) noexcept   { std::free (p); }
+
+//==============================================================================
+namespace
+{
+    struct ScanResult
+    {
+        juce::int64 numLines = 0, numWords = 0, numMatches = 0;
+    };
+
+    struct BenchmarkResult
+    {
+        ScanResult scan;
+        juce::int64 numAllocations = 0;
+    };
+
+    /** The shape of the text in a corpus. */
+    struct CorpusProfile
+    {
+        const char* name;
+        int maxWordsPerLine, maxWordLength;
+        bool multibyte;
+    };
+
+    const CorpusProfile corpusProfiles[] =
+    {
+        { "words",     16,  10, false },   // short lines of short words, like a log
+        { "longlines", 400, 20, false },   // few, very long lines
+        { "utf8",      16,  10, true  }    // about half the characters are multibyte
+    };
+
+    // One to four bytes each, so that no tokeniser can assume ASCII.
+    const char* const multibyteCharacters[] =
+    {
+        "\xc3\xa9", "\xc3\xbc", "\xc3\x9f", "\xce\xbb", "\xd0\xb6",     // é ü ß λ ж
+        "\xe4\xb8\xad", "\xe8\xaa\x9e", "\xe2\x82\xac",                 // 中 語 €
+        "\xf0\x9f\x98\x80"                                              // 😀
+    };
+
+    constexpr juce::int64 maximumInMemoryCorpusSize = 512 * 1024 * 1024;
+    constexpr juce::int64 maximumCompressedCorpusSize = 256 * 1024 * 1024;
+    constexpr size_t parallelCellSize = 4 * 1024 * 1024;
+    constexpr size_t readBufferSize = 1024 * 1024;
+    constexpr size_t budgetedMemory = 64 * 1024 * 1024;
+    constexpr int maximumScanThreads = 16;
+
+    // Parses a size like "1K", "100M" or "4G". A plain number is in MB.
+    juce::int64 parseSize (const juce::String& text)
+    {
+        auto value = text.getLargeIntValue();
+
+        switch (juce::CharacterFunctions::toUpperCase (text.getLastCharacter()))
+        {
+            case 'K':  return value * 1024;
+            case 'G':  return value * 1024 * 1024 * 1024;
+            default:   return value * 1024 * 1024;
+        }
+    }
+
+    // Writes a corpus of pseudo-random words and lines. The seed is fixed so every
+    // run measures the same bytes, and an existing corpus of the right size is reused.
+    juce::File createCorpus (juce::int64 numBytes, const CorpusProfile& profile)
+    {
+        auto file = juce::File::getSpecialLocation (juce::File::tempDirectory)
+                        .getChildFile ("FileReadingBenchmark_" + juce::String (profile.name)
+                                         + "_" + juce::String (numBytes) + ".txt");
+
+        if (file.getSize() == numBytes)
+            return file;
+
+        file.deleteFile();
+
+        juce::FileOutputStream out (file);
+        juce::MemoryOutputStream line;
+        juce::Random random (42);
+        juce::int64 written = 0;
+
+        while (written < numBytes)
+        {
+            line.reset();
+
+            for (int word = 0, numWords = 1 + random.nextInt (profile.maxWordsPerLine); word < numWords; ++word)
+            {
+                for (int i = 1 + random.nextInt (profile.maxWordLength); --i >= 0;)
+                {
+                    if (profile.multibyte && random.nextBool())
+                        line << multibyteCharacters[random.nextInt ((int) juce::numElementsInArray (multibyteCharacters))];
+                    else
+                        line.writeByte ((char) ('a' + random.nextInt (26)));
+                }
+
+                line.writeByte (word < numWords - 1 ? ' ' : '\n');
+            }
+
+            auto numToWrite = juce::jmin ((juce::int64) line.getDataSize(), numBytes - written);
+            out.write (line.getData(), (size_t) numToWrite);
+            written += numToWrite;
+        }
+
+        return file;
+    }
+
+    // Writes a gzipped copy of a corpus next to it, unless there's already one.
+    juce::File createCompressedCorpus (const juce::File& corpus)
+    {
+        auto file = corpus.getSiblingFile (corpus.getFileName() + ".gz");
+
+        if (file.existsAsFile() && file.getLastModificationTime() >= corpus.getLastModificationTime())
+            return file;
+
+        file.deleteFile();
+
+        juce::FileInputStream in (corpus);
+        juce::FileOutputStream out (file);
+        juce::GZIPCompressorOutputStream gzip (out, 6, juce::GZIPCompressorOutputStream::windowBitsGZIP);
+
+        gzip.writeFromInputStream (in, -1);
+        return file;
+    }
+
+    //==============================================================================
+    // Returns the most memory the process has had resident, in bytes. On Linux
+    // this is VmHWM, which resetPeakResidentBytes() can reset.
+    juce::int64 getPeakResidentBytes()
+    {
+       #if JUCE_WINDOWS
+        PROCESS_MEMORY_COUNTERS counters;
+
+        if (GetProcessMemoryInfo (GetCurrentProcess(), &counters, sizeof (counters)))
+            return (juce::int64) counters.PeakWorkingSetSize;
+
+        return 0;
+       #elif JUCE_LINUX
+        auto status = juce::StringArray::fromLines (juce::File ("/proc/self/status").loadFileAsString());
+
+        for (auto& line : status)
+            if (line.startsWith ("VmHWM:"))
+                return line.fromFirstOccurrenceOf (":", false, false).trim().getLargeIntValue() * 1024;
+
+        return 0;
+       #else
+        struct rusage usage;
+        getrusage (RUSAGE_SELF, &usage);
+        return (juce::int64) usage.ru_maxrss;   // in bytes on macOS
+       #endif
+    }
+
+    // Returns false if the peak couldn't be reset. File::replaceWithText() can't
+    // be used, as it writes a temporary file and renames it over the target.
+    bool resetPeakResidentBytes()
+    {
+       #if JUCE_LINUX
+        auto fd = ::open ("/proc/self/clear_refs", O_WRONLY);
+
+        if (fd < 0)
+            return false;
+
+        auto ok = ::write (fd, "5", 1) == 1;
+        ::close (fd);
+        return ok;
+       #else
+        return false;
+       #endif
+    }
+
+    //==============================================================================
+    // FileReadingTutorial_01::readFile
+    ScanResult loadFileAsStringPass (const juce::File& file)
+    {
+        auto text = file.loadFileAsString();
+        juce::ignoreUnused (text);
+        return {};
+    }
+
+    // The loop from FileReadingTutorial_02::readFile
+    ScanResult readNextLineLoop (const juce::File& file)
+    {
+        juce::FileInputStream inputStream (file);
+        juce::String asterix ("*");
+        ScanResult result;
+
+        while (! inputStream.isExhausted())
+        {
+            auto line = inputStream.readNextLine();
+
+            if (line.startsWith (asterix))
+                line = line.removeCharacters (asterix);
+
+            auto lineToInsert = line + juce::newLine;
+            juce::ignoreUnused (lineToInsert);
+            ++result.numLines;
+        }
+
+        return result;
+    }
+
+    // readUpToNextSpace from FileReadingTutorial_03
+    juce::String readUpToNextSpace (juce::FileInputStream& inputStream)
+    {
+        juce::MemoryBlock buffer (256);
+        auto* data = static_cast<char*> (buffer.getData());
+        size_t i = 0;
+
+        while ((data[i] = inputStream.readByte()) != 0 && i < buffer.getSize())
+            if (data[i++] == ' ')
+                break;
+
+        return juce::String::fromUTF8 (data, (int) i);
+    }
+
+    ScanResult readUpToNextSpaceLoop (const juce::File& file)
+    {
+        juce::FileInputStream inputStream (file);
+        ScanResult result;
+
+        while (! inputStream.isExhausted())
+        {
+            readUpToNextSpace (inputStream);
+            ++result.numWords;
+        }
+
+        return result;
+    }
+
+    // FileReadingTutorial_04::readFileMapped
+    ScanResult wordTokenizerPass (const juce::File& file)
+    {
+        juce::MemoryMappedFile mappedFile (file, juce::MemoryMappedFile::readOnly);
+        WordTokenizer tokenizer (static_cast<const char*> (mappedFile.getData()), mappedFile.getSize());
+        ScanResult result;
+        TextToken word;
+
+        while (tokenizer.next (word))
+            ++result.numWords;
+
+        return result;
+    }
+
+    // FileReadingTutorial_04::readFile
+    ScanResult streamWordTokenizerPass (const juce::File& file)
+    {
+        juce::FileInputStream inputStream (file);
+        StreamWordTokenizer tokenizer (inputStream);
+        ScanResult result;
+        TextToken word;
+
+        while (tokenizer.next (word))
+            ++result.numWords;
+
+        return result;
+    }
+
+    ScanResult textScannerPass (const juce::File& file, TextScanner::Implementation impl)
+    {
+        juce::MemoryMappedFile mappedFile (file, juce::MemoryMappedFile::readOnly);
+        std::vector<juce::int64> lineBreaks, wordBreaks;
+
+        TextScanner::findBreaks (static_cast<const char*> (mappedFile.getData()), mappedFile.getSize(),
+                                 0, lineBreaks, &wordBreaks, impl);
+
+        return { (juce::int64) lineBreaks.size(), (juce::int64) wordBreaks.size() };
+    }
+
+    //==============================================================================
+    // The TextFileLoader's scan of a mapped file in _05, on one thread.
+    ScanResult lineIndexPass (const juce::File& file)
+    {
+        juce::MemoryMappedFile mappedFile (file, juce::MemoryMappedFile::readOnly);
+        TextLineIndex index;
+
+        index.build (static_cast<const char*> (mappedFile.getData()), mappedFile.getSize());
+        return { index.getNumLines() };
+    }
+
+    // The TextFileLoader's parallel scan: one job per cell on a thread pool, with
+    // the results added to the index in file order.
+    ScanResult parallelLineIndexPass (const juce::File& file)
+    {
+        struct Job
+        {
+            std::vector<juce::int64> lineBreaks;
+            juce::WaitableEvent finished;
+        };
+
+        juce::MemoryMappedFile mappedFile (file, juce::MemoryMappedFile::readOnly);
+        auto* data = static_cast<const char*> (mappedFile.getData());
+        auto size = mappedFile.getSize();
+
+        std::vector<std::unique_ptr<Job>> jobs;
+        juce::ThreadPool pool (juce::jmin (juce::SystemStats::getNumCpus(), maximumScanThreads));
+
+        for (size_t start = 0; start < size; start += parallelCellSize)
+        {
+            jobs.emplace_back (new Job());
+            auto* job = jobs.back().get();
+
+            pool.addJob ([data, size, start, job]
+            {
+                TextScanner::findBreaks (data + start, juce::jmin (parallelCellSize, size - start),
+                                         (juce::int64) start, job->lineBreaks);
+                job->finished.signal();
+            });
+        }
+
+        TextLineIndex index;
+        size_t numBytesIndexed = 0;
+
+        for (auto& job : jobs)
+        {
+            job->finished.wait();
+            numBytesIndexed = juce::jmin (numBytesIndexed + parallelCellSize, size);
+            index.appendBreaks (job->lineBreaks, numBytesIndexed);
+            job.reset();
+        }
+
+        return { index.getNumLines() };
+    }
+
+    // The TextFileLoader's scan with a memory budget: read through a buffer rather
+    // than mapped, into an index that only keeps a sample of the breaks.
+    ScanResult budgetedLineIndexPass (const juce::File& file)
+    {
+        juce::FileInputStream input (file);
+        juce::HeapBlock<char> buffer (readBufferSize);
+        std::vector<juce::int64> lineBreaks;
+        TextLineIndex index;
+        size_t numBytesScanned = 0;
+
+        index.setMaximumNumBreaks (budgetedMemory / 4 / sizeof (juce::int64));
+
+        for (;;)
+        {
+            auto numRead = input.read (buffer, (int) readBufferSize);
+
+            if (numRead <= 0)
+                break;
+
+            lineBreaks.clear();
+            TextScanner::findBreaks (buffer, (size_t) numRead, (juce::int64) numBytesScanned, lineBreaks);
+            numBytesScanned += (size_t) numRead;
+            index.appendBreaks (lineBreaks, numBytesScanned);
+        }
+
+        return { index.getNumLines() };
+    }
+
+    // The TextFileLoader's scan of a gzipped file, decompressing as it goes.
+    ScanResult compressedLineIndexPass (const juce::File& compressedFile)
+    {
+        CompressedTextSource source (compressedFile, CompressedTextSource::Format::gzip);
+        std::vector<juce::int64> lineBreaks;
+        TextLineIndex index;
+        size_t numBytesScanned = 0;
+
+        source.decompressAll ([&] (const char* block, size_t numBytes)
+                              {
+                                  lineBreaks.clear();
+                                  TextScanner::findBreaks (block, numBytes, (juce::int64) numBytesScanned, lineBreaks);
+                                  numBytesScanned += numBytes;
+                                  index.appendBreaks (lineBreaks, numBytesScanned);
+                              },
+                              [] { return false; });
+
+        return { index.getNumLines() };
+    }
+
+    // What TextFileSearch does with a mapped file in _05.
+    ScanResult searchPass (const juce::File& file, TextSearch::Implementation impl)
+    {
+        juce::MemoryMappedFile mappedFile (file, juce::MemoryMappedFile::readOnly);
+        std::vector<juce::int64> matches;
+        const char pattern[] = "abc";
+
+        TextSearch::findAll (static_cast<const char*> (mappedFile.getData()), mappedFile.getSize(),
+                             pattern, sizeof (pattern) - 1, 0, matches, impl);
+
+        return { 0, 0, (juce::int64) matches.size() };
+    }
+
+    //==============================================================================
+    template <typename ScanFunction>
+    BenchmarkResult runBenchmark (const juce::String& name, juce::int64 numBytes, ScanFunction&& scan)
+    {
+        auto peakWasReset = resetPeakResidentBytes();
+
+        auto allocationsBefore = numAllocations.load();
+        auto startTicks = juce::Time::getHighResolutionTicks();
+        auto result = scan();
+        auto seconds = juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - startTicks);
+        auto allocations = numAllocations.load() - allocationsBefore;
+
+        std::cout << name.paddedRight (' ', 28)
+                  << juce::String (seconds * 1000.0, 1).paddedLeft (' ', 12) << " ms"
+                  << juce::String ((double) numBytes / (1024.0 * 1024.0) / seconds, 1).paddedLeft (' ', 12) << " MB/s"
+                  << juce::File::descriptionOfSizeInBytes (getPeakResidentBytes()).paddedLeft (' ', 12)
+                  << (peakWasReset ? " peak" : " peak since start")
+                  << "   lines: " << result.numLines
+                  << "   words: " << result.numWords;
+
+        if (result.numMatches > 0)
+            std::cout << "   matches: " << result.numMatches;
+
+        std::cout << "   allocations: " << allocations << std::endl;
+
+        return { result, allocations };
+    }
+
+    void skipBenchmark (const juce::String& name, const juce::String& reason)
+    {
+        std::cout << name.paddedRight (' ', 28) << "    skipped (" << reason << ")" << std::endl;
+    }
+
+    // The tokenisers may allocate a buffer up front, but never once per word.
+    bool checkNoAllocationsPerWord (const juce::String& name, const BenchmarkResult& result)
+    {
+        const juce::int64 maxFixedAllocations = 16;
+
+        if (result.scan.numWords <= maxFixedAllocations || result.numAllocations <= maxFixedAllocations)
+            return true;
+
+        std::cout << "FAILED: " << name << " made " << result.numAllocations << " allocations for "
+                  << result.scan.numWords << " words" << std::endl;
+        return false;
+    }
+
+    //==============================================================================
+    // The length of the longest common subsequence, by dynamic programming.
+    juce::int64 getLongestCommonSubsequenceLength (const std::vector<juce::uint64>& a, const std::vector<juce::uint64>& b)
+    {
+        std::vector<juce::int64> previous (b.size() + 1, 0), current (b.size() + 1, 0);
+
+        for (size_t i = 1; i <= a.size(); ++i)
+        {
+            for (size_t j = 1; j <= b.size(); ++j)
+                current[j] = a[i - 1] == b[j - 1] ? previous[j - 1] + 1 : juce::jmax (previous[j], current[j - 1]);
+
+            std::swap (previous, current);
+        }
+
+        return previous[b.size()];
+    }
+
+    // Returns the number of lines the hunks change, or -1 if the lines they leave
+    // alone don't pair up with equal lines in the same order.
+    juce::int64 countChangedLines (const std::vector<juce::uint64>& a, const std::vector<juce::uint64>& b,
+                                   const std::vector<TextLineDiff::Hunk>& hunks)
+    {
+        juce::int64 i = 0, j = 0, numChanged = 0;
+
+        auto skipUnchanged = [&] (juce::int64 endA, juce::int64 endB)
+        {
+            if (endA - i != endB - j || endA < i)
+                return false;
+
+            for (; i < endA; ++i, ++j)
+                if (a[(size_t) i] != b[(size_t) j])
+                    return false;
+
+            return true;
+        };
+
+        for (auto& hunk : hunks)
+        {
+            if (hunk.numA + hunk.numB == 0 || ! skipUnchanged (hunk.startA, hunk.startB))
+                return -1;
+
+            i += hunk.numA;
+            j += hunk.numB;
+            numChanged += hunk.numA + hunk.numB;
+        }
+
+        return skipUnchanged ((juce::int64) a.size(), (juce::int64) b.size()) ? numChanged : -1;
+    }
+
+    // The lists are at most 400 lines between them, which TextLineDiff always
+    // diffs exactly, so its diff must change no more lines than the LCS leaves.
+    bool checkLineDiffAgainstLCS()
+    {
+        const int numTrials = 5000, maximumNumLines = 200;
+        juce::Random random (1234);
+
+        for (int trial = 0; trial < numTrials; ++trial)
+        {
+            // A small alphabet repeats lines often, so there are many ways to
+            // pair them up. Half of the second lists are edited copies of the
+            // first, and the rest are unrelated.
+            auto alphabetSize = 1 + random.nextInt (8);
+            auto editProbability = random.nextBool() ? random.nextFloat() : 1.0f;
+            auto nextLine = [&] { return (juce::uint64) random.nextInt (alphabetSize); };
+
+            std::vector<juce::uint64> a, b;
+
+            for (auto n = random.nextInt (maximumNumLines + 1); --n >= 0;)
+                a.push_back (nextLine());
+
+            for (auto line : a)
+            {
+                if (b.size() >= (size_t) maximumNumLines)
+                    break;
+
+                if (random.nextFloat() >= editProbability)
+                    b.push_back (line);
+                else if (random.nextBool())
+                    b.push_back (nextLine());
+            }
+
+            while (b.size() < (size_t) maximumNumLines && random.nextFloat() < editProbability * 0.5f)
+                b.insert (b.begin() + random.nextInt ((int) b.size() + 1), nextLine());
+
+            auto numChanged = countChangedLines (a, b, TextLineDiff::compare (a, b));
+            auto expected = (juce::int64) (a.size() + b.size()) - 2 * getLongestCommonSubsequenceLength (a, b);
+
+            if (numChanged != expected)
+            {
+                std::cout << "FAILED: TextLineDiff " << (numChanged < 0 ? juce::String ("gave an invalid diff")
+                                                                        : "changed " + juce::String (numChanged) + " lines rather than "
+                                                                            + juce::String (expected))
+                          << " for random trial " << trial << std::endl;
+                return false;
+            }
+        }
+
+        std::cout << "TextLineDiff matched an LCS on " << numTrials << " random pairs of line lists" << std::endl;
+        return true;
+    }
+
+    //==============================================================================
+    bool runAllBenchmarks (const juce::File& corpus, juce::int64 numBytes)
+    {
+        bool allPassed = true;
+        const juce::String tooBig ("corpus too big");
+
+        if (numBytes <= maximumInMemoryCorpusSize)
+            runBenchmark ("loadFileAsString (_01)", numBytes, [&] { return loadFileAsStringPass (corpus); });
+        else
+            skipBenchmark ("loadFileAsString (_01)", tooBig);
+
+        runBenchmark ("readNextLine (_02)",      numBytes, [&] { return readNextLineLoop (corpus); });
+        runBenchmark ("readUpToNextSpace (_03)", numBytes, [&] { return readUpToNextSpaceLoop (corpus); });
+
+        allPassed &= checkNoAllocationsPerWord ("StreamWordTokenizer",
+                                                runBenchmark ("StreamWordTokenizer (_04)", numBytes,
+                                                              [&] { return streamWordTokenizerPass (corpus); }));
+
+        allPassed &= checkNoAllocationsPerWord ("WordTokenizer",
+                                                runBenchmark ("WordTokenizer (_04 mapped)", numBytes,
+                                                              [&] { return wordTokenizerPass (corpus); }));
+
+        for (auto impl : { TextScanner::Implementation::scalar,
+                           TextScanner::Implementation::sse2,
+                           TextScanner::Implementation::avx2 })
+        {
+            if (TextScanner::isAvailable (impl))
+                runBenchmark ("TextScanner " + juce::String (TextScanner::getName (impl)),
+                              numBytes, [&] { return textScannerPass (corpus, impl); });
+        }
+
+        runBenchmark ("line index (_05)",          numBytes, [&] { return lineIndexPass (corpus); });
+        runBenchmark ("parallel line index (_05)", numBytes, [&] { return parallelLineIndexPass (corpus); });
+        runBenchmark ("64MB budget (_05)",         numBytes, [&] { return budgetedLineIndexPass (corpus); });
+
+        if (numBytes <= maximumCompressedCorpusSize)
+        {
+            auto compressedCorpus = createCompressedCorpus (corpus);
+            runBenchmark ("gzip line index (_05)", numBytes, [&] { return compressedLineIndexPass (compressedCorpus); });
+        }
+        else
+        {
+            skipBenchmark ("gzip line index (_05)", tooBig);
+        }
+
+        for (auto impl : { TextSearch::Implementation::scalar,
+                           TextSearch::Implementation::sse2,
+                           TextSearch::Implementation::avx2 })
+        {
+            if (TextScanner::isAvailable (impl))
+                runBenchmark ("TextSearch " + juce::String (TextScanner::getName (impl)),
+                              numBytes, [&] { return searchPass (corpus, impl); });
+        }
+
+        return allPassed;
+    }
+}
+
+//==============================================================================
+int main (int argc, char* argv[])
+{
+    juce::ArgumentList args (argc, argv);
+
+    auto sizes = juce::StringArray::fromTokens (args.containsOption ("--sizes") ? args.getValueForOption ("--sizes")
+                                                                                : juce::String ("1K,1M,100M,1G"),
+                                                ",", {});
+
+    auto corpora = juce::StringArray::fromTokens (args.containsOption ("--corpora") ? args.getValueForOption ("--corpora")
+                                                                                    : juce::String ("words,longlines,utf8"),
+                                                  ",", {});
+
+    bool allPassed = checkLineDiffAgainstLCS();
+
+    for (auto& size : sizes)
+    {
+        auto numBytes = parseSize (size);
+
+        if (numBytes <= 0)
+            continue;
+
+        for (auto& profile : corpusProfiles)
+        {
+            if (! corpora.contains (profile.name))
+                continue;
+
+            std::cout << std::endl << "Corpus: " << size << " " << profile.name << std::endl;
+            auto corpus = createCorpus (numBytes, profile);
+
+            allPassed &= runAllBenchmarks (corpus, numBytes);
+        }
+    }
+
+    return allPassed ? 0 : 1;
+}
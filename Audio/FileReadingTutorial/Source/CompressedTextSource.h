@@ -0,0 +1,688 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE tutorials.
+   Copyright (c) 2020 - Raw Material Software Limited
+
+   The code included in this file is provided under the terms of the ISC license
+   http://www.isc.org/downloads/software-support-policy/isc-license. Permission
+   To use, copy, modify, and/or distribute this software for any purpose with or
+   without fee is hereby granted provided that the above copyright notice and
+   this permission notice appear in all copies.
+
+   THE SOFTWARE IS PROVIDED "AS IS" WITHOUT ANY WARRANTY, AND ALL WARRANTIES,
+   WHETHER EXPRESSED OR IMPLIED, INCLUDING MERCHANTABILITY AND FITNESS FOR
+   PURPOSE, ARE DISCLAIMED.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "TextDataSource.h"
+#include "SharedPageCache.h"
+
+// Random access into a gzip file needs zlib's inflatePrime() and
+// inflateSetDictionary(), which JUCE's GZIPDecompressorInputStream doesn't expose,
+// so this uses the system zlib (linked with -lz by the exporters in the .jucer).
+// JUCE's own copy of zlib is compiled inside its namespace, so the two don't
+// clash. Every macOS, Linux and BSD system has libz, so it's used there by
+// default, and elsewhere whenever JUCE itself links it (JUCE_INCLUDE_ZLIB_CODE=0).
+// Otherwise gzip files are still read through GZIPDecompressorInputStream, but
+// each backwards seek restarts from the beginning.
+#ifndef FILE_READING_TUTORIAL_USE_ZLIB
+ #if JUCE_MAC || JUCE_LINUX || JUCE_BSD || (defined (JUCE_INCLUDE_ZLIB_CODE) && ! JUCE_INCLUDE_ZLIB_CODE)
+  #define FILE_READING_TUTORIAL_USE_ZLIB 1
+ #else
+  #define FILE_READING_TUTORIAL_USE_ZLIB 0
+ #endif
+#endif
+
+// zstd support is optional, as it needs libzstd to be linked.
+#ifndef FILE_READING_TUTORIAL_USE_ZSTD
+ #define FILE_READING_TUTORIAL_USE_ZSTD 0
+#endif
+
+#if FILE_READING_TUTORIAL_USE_ZLIB
+ #include <zlib.h>
+#endif
+
+#if FILE_READING_TUTORIAL_USE_ZSTD
+ #include <zstd.h>
+#endif
+
+//==============================================================================
+/**
+    A TextDataSource that decompresses a gzip (or zstd) file as it's needed.
+
+    decompressAll() streams through the whole file once, on a background thread,
+    handing each block of text to a callback so it can be indexed. As it goes it
+    records checkpoints every 4MB or so: the state needed to start decoding
+    again from that point. getBytes() then decodes only the pages it's asked for,
+    starting from the nearest checkpoint, and keeps the decoded pages in the
+    SharedPageCache. So jumping into the middle of a huge file never restarts from byte 0,
+    and memory use is bounded by the page cache plus the checkpoints.
+
+    For gzip a checkpoint holds the 32K of text before it (the deflate window).
+    zstd frames are independent, so there a checkpoint is simply the start of a
+    frame; a file made of a single frame only has one.
+*/
+class CompressedTextSource  : public TextDataSource
+{
+public:
+    enum class Format
+    {
+        unknown,
+        gzip,
+        zstd
+    };
+
+    /** Looks at the first few bytes of a file to see if it's compressed. */
+    static Format detectFormat (const juce::File& file)
+    {
+        juce::FileInputStream input (file);
+        juce::uint8 magic[4] = {};
+
+        if (! input.openedOk() || input.read (magic, sizeof (magic)) < 2)
+            return Format::unknown;
+
+        if (magic[0] == 0x1f && magic[1] == 0x8b)
+            return Format::gzip;
+
+        if (magic[0] == 0x28 && magic[1] == 0xb5 && magic[2] == 0x2f && magic[3] == 0xfd)
+            return Format::zstd;
+
+        return Format::unknown;
+    }
+
+    static bool isSupported (Format format) noexcept
+    {
+        return format == Format::gzip
+            || (format == Format::zstd && FILE_READING_TUTORIAL_USE_ZSTD);
+    }
+
+    CompressedTextSource (const juce::File& fileToRead, Format formatToRead)
+        : file (fileToRead), format (formatToRead)
+    {
+        jassert (isSupported (format));
+    }
+
+    ~CompressedTextSource() override
+    {
+        pageCache->removeAll (ownerId);
+    }
+
+    /** Decompresses the whole file from the start, calling onBlock with each block
+        of text in turn and recording checkpoints along the way. Returns false if
+        the data was corrupt or shouldStop() returned true.
+    */
+    bool decompressAll (const std::function<void (const char*, size_t)>& onBlock,
+                        const std::function<bool()>& shouldStop)
+    {
+        addCheckpoint (0, 0, 0, true, nullptr, 0);
+
+       #if FILE_READING_TUTORIAL_USE_ZSTD
+        if (format == Format::zstd)
+            return decompressAllZstd (onBlock, shouldStop);
+       #endif
+
+       #if FILE_READING_TUTORIAL_USE_ZLIB
+        return decompressAllGzip (onBlock, shouldStop);
+       #else
+        return decompressAllWithJuce (onBlock, shouldStop);
+       #endif
+    }
+
+    size_t getSize() const override                 { return numBytesDecompressed; }
+
+    int getNumCheckpoints() const
+    {
+        const juce::ScopedLock sl (checkpointLock);
+        return (int) checkpoints.size();
+    }
+
+    const char* getBytes (juce::Range<juce::int64> range) override
+    {
+        jassert (range.getEnd() <= (juce::int64) getSize());
+
+        if (range.isEmpty())
+            return static_cast<const char*> (scratch.getData());
+
+        auto firstPage = range.getStart() / (juce::int64) pageSize;
+        auto lastPage  = (range.getEnd() - 1) / (juce::int64) pageSize;
+
+        if (firstPage == lastPage)
+        {
+            currentPage = getPage (firstPage);  // keeps the page alive while the caller has it
+            return currentPage->data.get() + (range.getStart() - firstPage * (juce::int64) pageSize);
+        }
+
+        // The range straddles pages, so it's copied together into one buffer.
+        scratch.ensureSize ((size_t) range.getLength());
+        auto* dest = static_cast<char*> (scratch.getData());
+
+        for (auto pageIndex = firstPage; pageIndex <= lastPage; ++pageIndex)
+        {
+            auto page = getPage (pageIndex);
+            auto pageStart = pageIndex * (juce::int64) pageSize;
+            auto piece = range.getIntersectionWith ({ pageStart, pageStart + (juce::int64) page->size });
+
+            std::memcpy (dest + (piece.getStart() - range.getStart()),
+                         page->data.get() + (piece.getStart() - pageStart),
+                         (size_t) piece.getLength());
+        }
+
+        return dest;
+    }
+
+private:
+    //==============================================================================
+    struct Checkpoint
+    {
+        juce::int64 compressedPosition, textPosition;
+        int bitOffset;          // gzip: bits of the preceding byte that belong to this point
+        bool isStreamStart;     // gzip: a member's header starts here
+        juce::HeapBlock<juce::uint8> window;
+    };
+
+    void addCheckpoint (juce::int64 compressedPosition, juce::int64 textPosition, int bitOffset,
+                        bool isStreamStart, const juce::uint8* circularWindow, size_t windowEnd)
+    {
+        std::unique_ptr<Checkpoint> checkpoint (new Checkpoint { compressedPosition, textPosition,
+                                                                 bitOffset, isStreamStart, {} });
+
+        // Unwraps the circular output buffer so the window is in text order.
+        if (circularWindow != nullptr)
+        {
+            checkpoint->window.malloc (windowSize);
+            std::memcpy (checkpoint->window.get(), circularWindow + windowEnd, windowSize - windowEnd);
+            std::memcpy (checkpoint->window.get() + (windowSize - windowEnd), circularWindow, windowEnd);
+        }
+
+        const juce::ScopedLock sl (checkpointLock);
+        checkpoints.push_back (std::move (checkpoint));
+    }
+
+    // Checkpoints are only ever added, so the one returned stays valid.
+    const Checkpoint* findCheckpoint (juce::int64 textPosition) const
+    {
+        const juce::ScopedLock sl (checkpointLock);
+
+        auto next = std::upper_bound (checkpoints.begin(), checkpoints.end(), textPosition,
+                                      [] (juce::int64 pos, const std::unique_ptr<Checkpoint>& c) { return pos < c->textPosition; });
+
+        jassert (next != checkpoints.begin());
+        return (next - 1)->get();
+    }
+
+    //==============================================================================
+    /** Decodes forwards from a checkpoint. */
+    struct Decoder
+    {
+        virtual ~Decoder() = default;
+        virtual bool seekTo (const Checkpoint&) = 0;
+        virtual size_t read (char* dest, size_t numBytes) = 0;
+    };
+
+    // While the file is still being decompressed, the last page may have been
+    // decoded before all of its text was available, in which case it's redone.
+    SharedPageCache::PagePtr getPage (juce::int64 pageIndex)
+    {
+        auto start = pageIndex * (juce::int64) pageSize;
+        auto expectedSize = juce::jmin (pageSize, getSize() - (size_t) start);
+
+        auto page = pageCache->find (ownerId, pageIndex);
+
+        if (page != nullptr && page->size == expectedSize)
+            return page;
+
+        auto newPage = std::make_shared<SharedPageCache::Page> (expectedSize);
+        newPage->size = readText (start, newPage->data.get(), expectedSize);
+        return pageCache->insert (ownerId, pageIndex, std::move (newPage));
+    }
+
+    // Keeps decoding from where the last read finished if that's on the way to the
+    // requested position, and otherwise restarts from the nearest checkpoint.
+    size_t readText (juce::int64 position, char* dest, size_t numBytes)
+    {
+        auto* checkpoint = findCheckpoint (position);
+
+        if (decoder == nullptr || decoderPosition > position || decoderPosition < checkpoint->textPosition)
+        {
+            if (decoder == nullptr)
+                decoder = createDecoder();
+
+            if (! decoder->seekTo (*checkpoint))
+            {
+                decoder.reset();
+                return 0;
+            }
+
+            decoderPosition = checkpoint->textPosition;
+        }
+
+        char skipBuffer[8192];
+
+        while (decoderPosition < position)
+        {
+            auto numRead = decoder->read (skipBuffer, (size_t) juce::jmin ((juce::int64) sizeof (skipBuffer), position - decoderPosition));
+
+            if (numRead == 0)
+                return 0;
+
+            decoderPosition += (juce::int64) numRead;
+        }
+
+        size_t total = 0;
+
+        while (total < numBytes)
+        {
+            auto numRead = decoder->read (dest + total, numBytes - total);
+
+            if (numRead == 0)
+                break;
+
+            total += numRead;
+        }
+
+        decoderPosition += (juce::int64) total;
+        return total;
+    }
+
+    std::unique_ptr<Decoder> createDecoder() const
+    {
+       #if FILE_READING_TUTORIAL_USE_ZSTD
+        if (format == Format::zstd)
+            return std::unique_ptr<Decoder> (new ZstdDecoder (file));
+       #endif
+
+       #if FILE_READING_TUTORIAL_USE_ZLIB
+        return std::unique_ptr<Decoder> (new GzipDecoder (file));
+       #else
+        return std::unique_ptr<Decoder> (new JuceGzipDecoder (file));
+       #endif
+    }
+
+   #if FILE_READING_TUTORIAL_USE_ZLIB
+    //==============================================================================
+    // This is the approach used by zlib's zran.c example: inflate a block at a time,
+    // and at block boundaries note the input position, the bit offset and the last
+    // 32K of output.
+    bool decompressAllGzip (const std::function<void (const char*, size_t)>& onBlock,
+                            const std::function<bool()>& shouldStop)
+    {
+        juce::FileInputStream input (file);
+
+        if (! input.openedOk())
+            return false;
+
+        z_stream stream {};
+
+        if (inflateInit2 (&stream, gzipWindowBits) != Z_OK)
+            return false;
+
+        juce::HeapBlock<juce::uint8> inputBuffer (inputBufferSize), window (windowSize, true);
+        juce::int64 totalIn = 0, totalOut = 0, lastCheckpoint = 0;
+        auto result = false, atMemberStart = true;
+        stream.avail_out = 0;
+
+        for (;;)
+        {
+            if (stream.avail_in == 0)
+            {
+                auto numRead = input.read (inputBuffer, inputBufferSize);
+
+                if (numRead <= 0)
+                {
+                    result = atMemberStart;  // false if the file is truncated
+                    break;
+                }
+
+                stream.next_in  = inputBuffer;
+                stream.avail_in = (uInt) numRead;
+            }
+
+            if (stream.avail_out == 0)
+            {
+                stream.next_out  = window;
+                stream.avail_out = windowSize;
+            }
+
+            auto* blockStart = stream.next_out;
+            auto inBefore = stream.avail_in, outBefore = stream.avail_out;
+            auto status = inflate (&stream, Z_BLOCK);
+            auto numProduced = outBefore - stream.avail_out;
+
+            totalIn  += inBefore - stream.avail_in;
+            totalOut += numProduced;
+
+            if (numProduced > 0)
+            {
+                atMemberStart = false;
+                onBlock (reinterpret_cast<const char*> (blockStart), numProduced);
+                numBytesDecompressed = (size_t) totalOut;
+            }
+
+            if (status == Z_STREAM_END)
+            {
+                // Another gzip member may follow, so decoding carries on with a
+                // fresh header.
+                inflateReset (&stream);
+                atMemberStart = true;
+                addCheckpoint (totalIn, totalOut, 0, true, nullptr, 0);
+                lastCheckpoint = totalOut;
+                continue;
+            }
+
+            if (status != Z_OK && status != Z_BUF_ERROR)
+            {
+                // Padding after the last member isn't an error.
+                result = (status == Z_DATA_ERROR && atMemberStart && totalOut > 0);
+                break;
+            }
+
+            if ((stream.data_type & 128) != 0 && (stream.data_type & 64) == 0
+                 && totalOut - lastCheckpoint > (juce::int64) checkpointSpacing)
+            {
+                addCheckpoint (totalIn, totalOut, stream.data_type & 7, false, window, windowSize - stream.avail_out);
+                lastCheckpoint = totalOut;
+            }
+
+            if (shouldStop())
+                break;
+        }
+
+        inflateEnd (&stream);
+        return result;
+    }
+
+    struct GzipDecoder  : public Decoder
+    {
+        explicit GzipDecoder (const juce::File& f) : file (f) {}
+
+        ~GzipDecoder() override
+        {
+            if (initialised)
+                inflateEnd (&stream);
+        }
+
+        bool seekTo (const Checkpoint& checkpoint) override
+        {
+            if (initialised)
+                inflateEnd (&stream);
+
+            stream = {};
+            initialised = false;
+            input.reset (new juce::FileInputStream (file));
+
+            if (! input->openedOk())
+                return false;
+
+            if (checkpoint.isStreamStart)
+            {
+                input->setPosition (checkpoint.compressedPosition);
+                initialised = (inflateInit2 (&stream, gzipWindowBits) == Z_OK);
+                raw = false;
+                return initialised;
+            }
+
+            input->setPosition (checkpoint.compressedPosition - (checkpoint.bitOffset != 0 ? 1 : 0));
+            initialised = (inflateInit2 (&stream, -15) == Z_OK);
+            raw = true;
+
+            if (! initialised)
+                return false;
+
+            if (checkpoint.bitOffset != 0)
+            {
+                auto byte = (juce::uint8) input->readByte();
+                inflatePrime (&stream, checkpoint.bitOffset, byte >> (8 - checkpoint.bitOffset));
+            }
+
+            inflateSetDictionary (&stream, checkpoint.window, windowSize);
+            return true;
+        }
+
+        size_t read (char* dest, size_t numBytes) override
+        {
+            if (! initialised)
+                return 0;
+
+            stream.next_out  = reinterpret_cast<Bytef*> (dest);
+            stream.avail_out = (uInt) numBytes;
+
+            while (stream.avail_out > 0)
+            {
+                if (stream.avail_in == 0 && ! refill())
+                    break;
+
+                auto status = inflate (&stream, Z_NO_FLUSH);
+
+                if (status == Z_STREAM_END)
+                {
+                    if (! startNextMember())
+                        break;
+                }
+                else if (status != Z_OK && status != Z_BUF_ERROR)
+                {
+                    break;
+                }
+            }
+
+            return numBytes - stream.avail_out;
+        }
+
+    private:
+        bool refill()
+        {
+            auto numRead = input->read (inputBuffer, inputBufferSize);
+
+            if (numRead <= 0)
+                return false;
+
+            stream.next_in  = inputBuffer;
+            stream.avail_in = (uInt) numRead;
+            return true;
+        }
+
+        // A raw inflate stops before the member's 8-byte trailer, which has to be
+        // skipped before the next header can be parsed.
+        bool startNextMember()
+        {
+            if (raw)
+            {
+                for (int i = 0; i < 8; ++i)
+                {
+                    if (stream.avail_in == 0 && ! refill())
+                        return false;
+
+                    ++stream.next_in;
+                    --stream.avail_in;
+                }
+
+                raw = false;
+            }
+
+            return inflateReset2 (&stream, gzipWindowBits) == Z_OK;
+        }
+
+        juce::File file;
+        std::unique_ptr<juce::FileInputStream> input;
+        juce::HeapBlock<juce::uint8> inputBuffer { inputBufferSize };
+        z_stream stream {};
+        bool initialised = false, raw = false;
+    };
+   #else
+    //==============================================================================
+    bool decompressAllWithJuce (const std::function<void (const char*, size_t)>& onBlock,
+                                const std::function<bool()>& shouldStop)
+    {
+        juce::GZIPDecompressorInputStream input (new juce::FileInputStream (file), true,
+                                                 juce::GZIPDecompressorInputStream::gzipFormat);
+        juce::HeapBlock<char> buffer (inputBufferSize);
+        juce::int64 totalOut = 0;
+
+        while (! shouldStop())
+        {
+            auto numRead = input.read (buffer, inputBufferSize);
+
+            if (numRead <= 0)
+                return true;
+
+            onBlock (buffer, (size_t) numRead);
+            totalOut += numRead;
+            numBytesDecompressed = (size_t) totalOut;
+        }
+
+        return false;
+    }
+
+    struct JuceGzipDecoder  : public Decoder
+    {
+        explicit JuceGzipDecoder (const juce::File& f) : file (f) {}
+
+        bool seekTo (const Checkpoint&) override
+        {
+            input.reset (new juce::GZIPDecompressorInputStream (new juce::FileInputStream (file), true,
+                                                                juce::GZIPDecompressorInputStream::gzipFormat));
+            return true;
+        }
+
+        size_t read (char* dest, size_t numBytes) override
+        {
+            auto numRead = input != nullptr ? input->read (dest, (int) numBytes) : 0;
+            return numRead > 0 ? (size_t) numRead : 0;
+        }
+
+        juce::File file;
+        std::unique_ptr<juce::GZIPDecompressorInputStream> input;
+    };
+   #endif
+
+   #if FILE_READING_TUTORIAL_USE_ZSTD
+    //==============================================================================
+    bool decompressAllZstd (const std::function<void (const char*, size_t)>& onBlock,
+                            const std::function<bool()>& shouldStop)
+    {
+        juce::FileInputStream input (file);
+        std::unique_ptr<ZSTD_DStream, decltype (&ZSTD_freeDStream)> stream (ZSTD_createDStream(), &ZSTD_freeDStream);
+
+        if (! input.openedOk() || stream == nullptr)
+            return false;
+
+        ZSTD_initDStream (stream.get());
+
+        juce::HeapBlock<char> inputData (ZSTD_DStreamInSize()), outputData (ZSTD_DStreamOutSize());
+        ZSTD_inBuffer in { inputData.get(), 0, 0 };
+        juce::int64 bufferStart = 0, totalOut = 0, lastCheckpoint = 0;
+        size_t status = 0;
+
+        while (! shouldStop())
+        {
+            if (in.pos == in.size)
+            {
+                bufferStart += (juce::int64) in.size;
+                auto numRead = input.read (inputData, (int) ZSTD_DStreamInSize());
+
+                if (numRead <= 0)
+                    return status == 0;  // otherwise the last frame was cut short
+
+                in = { inputData.get(), (size_t) numRead, 0 };
+            }
+
+            ZSTD_outBuffer out { outputData.get(), ZSTD_DStreamOutSize(), 0 };
+            status = ZSTD_decompressStream (stream.get(), &out, &in);
+
+            if (ZSTD_isError (status))
+                return false;
+
+            if (out.pos > 0)
+            {
+                onBlock (outputData, out.pos);
+                totalOut += (juce::int64) out.pos;
+                numBytesDecompressed = (size_t) totalOut;
+            }
+
+            // A frame has finished, so the next one can be decoded on its own.
+            if (status == 0 && totalOut - lastCheckpoint > (juce::int64) checkpointSpacing)
+            {
+                addCheckpoint (bufferStart + (juce::int64) in.pos, totalOut, 0, true, nullptr, 0);
+                lastCheckpoint = totalOut;
+            }
+        }
+
+        return false;
+    }
+
+    struct ZstdDecoder  : public Decoder
+    {
+        explicit ZstdDecoder (const juce::File& f) : file (f) {}
+
+        bool seekTo (const Checkpoint& checkpoint) override
+        {
+            input.reset (new juce::FileInputStream (file));
+
+            if (! input->openedOk() || stream == nullptr)
+                return false;
+
+            input->setPosition (checkpoint.compressedPosition);
+            ZSTD_DCtx_reset (stream.get(), ZSTD_reset_session_only);
+            in = { inputData.get(), 0, 0 };
+            return true;
+        }
+
+        size_t read (char* dest, size_t numBytes) override
+        {
+            ZSTD_outBuffer out { dest, numBytes, 0 };
+
+            while (out.pos < out.size)
+            {
+                if (in.pos == in.size)
+                {
+                    auto numRead = input->read (inputData, (int) ZSTD_DStreamInSize());
+
+                    if (numRead <= 0)
+                        break;
+
+                    in = { inputData.get(), (size_t) numRead, 0 };
+                }
+
+                if (ZSTD_isError (ZSTD_decompressStream (stream.get(), &out, &in)))
+                    break;
+            }
+
+            return out.pos;
+        }
+
+        juce::File file;
+        std::unique_ptr<juce::FileInputStream> input;
+        std::unique_ptr<ZSTD_DStream, decltype (&ZSTD_freeDStream)> stream { ZSTD_createDStream(), &ZSTD_freeDStream };
+        juce::HeapBlock<char> inputData { ZSTD_DStreamInSize() };
+        ZSTD_inBuffer in { nullptr, 0, 0 };
+    };
+   #endif
+
+    //==============================================================================
+    static constexpr int gzipWindowBits = 15 + 16;   // a gzip header and trailer
+    static constexpr size_t windowSize = 32768;
+    static constexpr int inputBufferSize = 64 * 1024;
+    static constexpr size_t checkpointSpacing = 4 * 1024 * 1024;
+    static constexpr size_t pageSize = 256 * 1024;
+
+    juce::File file;
+    Format format;
+    std::atomic<size_t> numBytesDecompressed { 0 };
+
+    juce::CriticalSection checkpointLock;
+    std::vector<std::unique_ptr<Checkpoint>> checkpoints;
+
+    // These are only used by getBytes().
+    std::unique_ptr<Decoder> decoder;
+    juce::int64 decoderPosition = 0;
+    juce::SharedResourcePointer<SharedPageCache> pageCache;
+    const juce::uint64 ownerId = pageCache->createOwnerId();
+    SharedPageCache::PagePtr currentPage;
+    juce::MemoryBlock scratch { 1 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (CompressedTextSource)
+};
@@ -0,0 +1,95 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE tutorials.
+   Copyright (c) 2020 - Raw Material Software Limited
+
+   The code included in this file is provided under the terms of the ISC license
+   http://www.isc.org/downloads/software-support-policy/isc-license. Permission
+   To use, copy, modify, and/or distribute this software for any purpose with or
+   without fee is hereby granted provided that the above copyright notice and
+   this permission notice appear in all copies.
+
+   THE SOFTWARE IS PROVIDED "AS IS" WITHOUT ANY WARRANTY, AND ALL WARRANTIES,
+   WHETHER EXPRESSED OR IMPLIED, INCLUDING MERCHANTABILITY AND FITNESS FOR
+   PURPOSE, ARE DISCLAIMED.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#if JUCE_LINUX
+ #include <sys/inotify.h>
+ #include <poll.h>
+ #include <unistd.h>
+#endif
+
+//==============================================================================
+/**
+    Lets a background thread sleep until a file has been written to.
+
+    On Linux this uses inotify, so the thread wakes up as soon as the file is
+    modified. Elsewhere (or if inotify can't be used) isWatching() returns false
+    and the caller should just poll the file's size instead.
+*/
+class FileChangeWatcher
+{
+public:
+    explicit FileChangeWatcher (const juce::File& fileToWatch)
+    {
+       #if JUCE_LINUX
+        handle = inotify_init1 (IN_NONBLOCK | IN_CLOEXEC);
+
+        if (handle >= 0
+             && inotify_add_watch (handle, fileToWatch.getFullPathName().toRawUTF8(),
+                                   IN_MODIFY | IN_ATTRIB | IN_CLOSE_WRITE | IN_MOVE_SELF | IN_DELETE_SELF) < 0)
+        {
+            close (handle);
+            handle = -1;
+        }
+       #else
+        juce::ignoreUnused (fileToWatch);
+       #endif
+    }
+
+    ~FileChangeWatcher()
+    {
+       #if JUCE_LINUX
+        if (handle >= 0)
+            close (handle);
+       #endif
+    }
+
+    bool isWatching() const noexcept    { return handle >= 0; }
+
+    /** Blocks until the file changes or the timeout expires, and returns true if
+        it changed. Only call this if isWatching() returns true.
+    */
+    bool waitForChange (int timeoutMs)
+    {
+        jassert (isWatching());
+
+       #if JUCE_LINUX
+        pollfd request { handle, POLLIN, 0 };
+
+        if (poll (&request, 1, timeoutMs) <= 0)
+            return false;
+
+        char events[4096];
+
+        while (read (handle, events, sizeof (events)) > 0)
+        {}
+
+        return true;
+       #else
+        juce::ignoreUnused (timeoutMs);
+        return false;
+       #endif
+    }
+
+private:
+    int handle = -1;
+
+    JUCE_DECLARE_NON_COPYABLE (FileChangeWatcher)
+};
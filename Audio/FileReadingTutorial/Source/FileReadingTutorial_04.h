@@ -45,9 +45,12 @@
 
 #pragma once
 
+#include "TextTokenizer.h"
+
 //==============================================================================
 class MainContentComponent   : public juce::Component,
-                               public juce::FilenameComponentListener
+                               public juce::FilenameComponentListener,
+                               private juce::Timer
 {
 public:
     MainContentComponent()
@@ -70,19 +73,29 @@ public:
         textContent->setReadOnly (true);
         textContent->setCaretVisible (false);
 
+        mapToggle.reset (new juce::ToggleButton ("Memory-mapped"));
+        addAndMakeVisible (mapToggle.get());
+        mapToggle->setToggleState (true, juce::dontSendNotification);
+
         setSize (600, 400);
     }
 
     void resized() override
     {
-        fileComp->setBounds    (10, 10, getWidth() - 20, 20);
+        fileComp->setBounds    (10, 10, getWidth() - 150, 20);
+        mapToggle->setBounds   (getWidth() - 130, 10, 120, 20);
         textContent->setBounds (10, 40, getWidth() - 20, getHeight() - 50);
     }
 
     void filenameComponentChanged (juce::FilenameComponent* fileComponentThatHasChanged) override
     {
         if (fileComponentThatHasChanged == fileComp.get())
-            readFile (fileComp->getCurrentFile());
+        {
+            if (mapToggle->getToggleState())
+                readFileMapped (fileComp->getCurrentFile());
+            else
+                readFile (fileComp->getCurrentFile());
+        }
     }
 
     static juce::Colour getRandomColour (float minBrightness)
@@ -96,21 +109,12 @@ public:
                                                        : colour.withBrightness (minBrightness);
     }
 
-    static juce::String readUpToNextSpace (juce::FileInputStream& inputStream)
-    {
-        juce::MemoryBlock buffer (256);
-        auto* data = static_cast<char*> (buffer.getData());
-        size_t i = 0;
-
-        while ((data[i] = inputStream.readByte()) != 0 && i < buffer.getSize())
-            if (data[i++] == ' ')
-                break;
-
-        return juce::String::fromUTF8 (data, (int) i);
-    }
-
     void readFile (const juce::File& fileToRead)
     {
+        stopTimer();
+        mappedWords = {};
+        mappedFile.reset();
+
         if (! fileToRead.existsAsFile())
             return;  // file doesn't exist
 
@@ -121,17 +125,83 @@ public:
 
         textContent->clear();
 
-        while (! inputStream.isExhausted())
+        StreamWordTokenizer tokenizer (inputStream);
+        TextToken word;
+
+        while (tokenizer.next (word))
         {
-            auto nextWord = readUpToNextSpace (inputStream);
             textContent->setColour (juce::TextEditor::textColourId, getRandomColour (0.75f));
-            textContent->insertTextAtCaret (nextWord);
+            textContent->insertTextAtCaret (word.toString());
         }
     }
 
+    void readFileMapped (const juce::File& fileToRead)
+    {
+        stopTimer();
+        mappedWords = {};
+        mappedFile.reset();
+
+        if (! fileToRead.existsAsFile())
+            return;  // file doesn't exist
+
+        // The OS pages the file in on demand, so nothing is copied onto the heap
+        // up front and the words are tokenised directly out of the mapped region.
+        mappedFile.reset (new juce::MemoryMappedFile (fileToRead, juce::MemoryMappedFile::readOnly));
+
+        if (mappedFile->getData() == nullptr)
+        {
+            mappedFile.reset();
+            readFile (fileToRead);  // mapping failed (e.g. an empty file), so use the stream
+            return;
+        }
+
+        textContent->clear();
+        mappedWords = WordTokenizer (static_cast<const char*> (mappedFile->getData()), mappedFile->getSize());
+
+        appendMappedWords();                     // show the first screen straight away..
+        startTimer (mappedAppendIntervalMs);     // ..and feed in the rest without blocking
+    }
+
 private:
-    std::unique_ptr<juce::FilenameComponent> fileComp;
-    std::unique_ptr<juce::TextEditor>        textContent;
+    void timerCallback() override
+    {
+        appendMappedWords();
+    }
+
+    // Inserts the next slice of words from the mapped region. Each word keeps its
+    // trailing space, just like the stream version.
+    void appendMappedWords()
+    {
+        if (mappedFile == nullptr)
+        {
+            stopTimer();
+            return;
+        }
+
+        TextToken word;
+
+        for (int i = 0; i < wordsPerSlice && mappedWords.next (word); ++i)
+        {
+            textContent->setColour (juce::TextEditor::textColourId, getRandomColour (0.75f));
+            textContent->insertTextAtCaret (word.toString());
+        }
+
+        if (mappedWords.isFinished())
+        {
+            stopTimer();
+            mappedWords = {};
+            mappedFile.reset();
+        }
+    }
+
+    static constexpr int wordsPerSlice = 2000;
+    static constexpr int mappedAppendIntervalMs = 10;
+
+    std::unique_ptr<juce::FilenameComponent>  fileComp;
+    std::unique_ptr<juce::TextEditor>         textContent;
+    std::unique_ptr<juce::ToggleButton>       mapToggle;
+    std::unique_ptr<juce::MemoryMappedFile>   mappedFile;
+    WordTokenizer mappedWords;
 
     //==============================================================================
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MainContentComponent)
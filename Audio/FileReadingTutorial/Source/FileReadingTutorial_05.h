@@ -0,0 +1,300 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE tutorials.
+   Copyright (c) 2020 - Raw Material Software Limited
+
+   The code included in this file is provided under the terms of the ISC license
+   http://www.isc.org/downloads/software-support-policy/isc-license. Permission
+   To use, copy, modify, and/or distribute this software for any purpose with or
+   without fee is hereby granted provided that the above copyright notice and
+   this permission notice appear in all copies.
+
+   THE SOFTWARE IS PROVIDED "AS IS" WITHOUT ANY WARRANTY, AND ALL WARRANTIES,
+   WHETHER EXPRESSED OR IMPLIED, INCLUDING MERCHANTABILITY AND FITNESS FOR
+   PURPOSE, ARE DISCLAIMED.
+
+  ==============================================================================
+*/
+
+/*******************************************************************************
+ The block below describes the properties of this PIP. A PIP is a short snippet
+ of code that can be read by the Projucer and used to generate a JUCE project.
+
+ BEGIN_JUCE_PIP_METADATA
+
+ name:             FileReadingTutorial
+ version:          5.0.0
+ vendor:           JUCE
+ website:          http://juce.com
+ description:      Reads and displays a text file.
+
+ dependencies:     juce_core, juce_data_structures, juce_events, juce_graphics,
+                   juce_gui_basics
+ exporters:        xcode_mac, vs2019, linux_make
+
+ type:             Component
+ mainClass:        MainContentComponent
+
+ useLocalCopy:     1
+
+ END_JUCE_PIP_METADATA
+
+*******************************************************************************/
+
+
+#pragma once
+
+#include "TextFileView.h"
+#include "TextDiffView.h"
+#include "TextStatisticsPanel.h"
+
+//==============================================================================
+class MainContentComponent   : public juce::Component,
+                               public juce::FilenameComponentListener
+{
+public:
+    MainContentComponent()
+    {
+        fileComp.reset (new juce::FilenameComponent ("fileComp",
+                                                     {},                       // current file
+                                                     false,                    // can edit file name,
+                                                     false,                    // is directory,
+                                                     false,                    // is for saving,
+                                                     {},                       // browser wildcard suffix,
+                                                     {},                       // enforced suffix,
+                                                     "Select file to open"));  // text when nothing selected
+        addAndMakeVisible (fileComp.get());
+        fileComp->addListener (this);
+        fileComp->setDefaultBrowseTarget (juce::File::getSpecialLocation (juce::File::userDocumentsDirectory));
+
+        textView.reset (new TextFileView());  // [1]
+        addAndMakeVisible (textView.get());
+
+        diffView.reset (new TextDiffView());
+        addChildComponent (diffView.get());
+        diffView->onFinished = [this] { updateMatchLabel(); };
+
+        statsPanel.reset (new TextStatisticsPanel());
+        addChildComponent (statsPanel.get());
+
+        statsToggle.reset (new juce::ToggleButton ("Stats"));
+        addAndMakeVisible (statsToggle.get());
+        statsToggle->onClick = [this] { showStatistics (statsToggle->getToggleState()); };
+
+        diffButton.reset (new juce::TextButton ("Diff..."));
+        addAndMakeVisible (diffButton.get());
+        diffButton->onClick = [this] { diffView->isVisible() ? closeDiff() : chooseFileToDiff(); };
+
+        colourToggle.reset (new juce::ToggleButton ("Colour words"));
+        addAndMakeVisible (colourToggle.get());
+        colourToggle->onClick = [this] { textView->setWordColouring (colourToggle->getToggleState()); };  // [3]
+
+        followToggle.reset (new juce::ToggleButton ("Follow"));
+        addAndMakeVisible (followToggle.get());
+        followToggle->onClick = [this] { textView->setFollowing (followToggle->getToggleState()); };      // [4]
+
+        limitToggle.reset (new juce::ToggleButton ("64MB limit"));
+        addAndMakeVisible (limitToggle.get());
+        limitToggle->onClick = [this] { textView->setMemoryBudget (limitToggle->getToggleState() ? memoryLimit : 0); };
+
+        syntaxToggle.reset (new juce::ToggleButton ("Syntax"));
+        addAndMakeVisible (syntaxToggle.get());
+        syntaxToggle->onClick = [this] { textView->setSyntaxHighlighter (syntaxToggle->getToggleState() ? createHighlighter() : nullptr); };
+
+        timingsToggle.reset (new juce::ToggleButton ("Timings"));
+        addAndMakeVisible (timingsToggle.get());
+        timingsToggle->onClick = [this] { textView->setShowingTimings (timingsToggle->getToggleState()); };
+
+        exportButton.reset (new juce::TextButton ("Export..."));
+        addAndMakeVisible (exportButton.get());
+        exportButton->onClick = [this] { exportTimings(); };
+
+        searchBox.reset (new juce::TextEditor ("searchBox"));
+        addAndMakeVisible (searchBox.get());
+        searchBox->setTextToShowWhenEmpty ("Find", juce::Colours::grey);
+        searchBox->onTextChange = [this] { textView->findText (searchBox->getText()); updateMatchLabel(); };  // [5]
+        searchBox->onReturnKey  = [this] { textView->findNext(); };
+
+        previousButton.reset (new juce::TextButton ("<"));
+        addAndMakeVisible (previousButton.get());
+        previousButton->onClick = [this] { diffView->isVisible() ? diffView->previousHunk() : textView->findPrevious(); };
+
+        nextButton.reset (new juce::TextButton (">"));
+        addAndMakeVisible (nextButton.get());
+        nextButton->onClick = [this] { diffView->isVisible() ? diffView->nextHunk() : textView->findNext(); };
+
+        matchLabel.reset (new juce::Label());
+        addAndMakeVisible (matchLabel.get());
+        textView->onSearchProgress = [this] { updateMatchLabel(); };
+
+        setSize (800, 400);
+    }
+
+    void resized() override
+    {
+        fileComp->setBounds     (10, 10, getWidth() - 400, 20);
+        statsToggle->setBounds  (getWidth() - 385, 10, 60, 20);
+        limitToggle->setBounds  (getWidth() - 320, 10, 110, 20);
+        colourToggle->setBounds (getWidth() - 210, 10, 120, 20);
+        followToggle->setBounds (getWidth() - 80,  10, 70, 20);
+
+        searchBox->setBounds      (10, 40, getWidth() - 560, 20);
+        diffButton->setBounds     (getWidth() - 540, 40, 70, 20);
+        timingsToggle->setBounds  (getWidth() - 460, 40, 80, 20);
+        exportButton->setBounds   (getWidth() - 375, 40, 65, 20);
+        syntaxToggle->setBounds   (getWidth() - 300, 40, 80, 20);
+        previousButton->setBounds (getWidth() - 210, 40, 30, 20);
+        nextButton->setBounds     (getWidth() - 175, 40, 30, 20);
+        matchLabel->setBounds     (getWidth() - 140, 40, 130, 20);
+
+        auto viewArea = juce::Rectangle<int> (10, 70, getWidth() - 20, getHeight() - 80);
+
+        if (statsPanel->isVisible())
+            statsPanel->setBounds (viewArea.removeFromRight (statsPanelWidth).withTrimmedLeft (10));
+
+        textView->setBounds     (viewArea);
+        diffView->setBounds     (viewArea);
+    }
+
+    void filenameComponentChanged (juce::FilenameComponent* fileComponentThatHasChanged) override
+    {
+        if (fileComponentThatHasChanged == fileComp.get())
+            readFile (fileComp->getCurrentFile());
+    }
+
+    void readFile (const juce::File& fileToRead)
+    {
+        closeDiff();
+        textView->loadFile (fileToRead);  // [2]
+        textView->findText (searchBox->getText());
+
+        if (statsPanel->isVisible())
+            statsPanel->count (fileToRead);
+    }
+
+    /** Shows or hides the word and line statistics of the current file. */
+    void showStatistics (bool shouldShow)
+    {
+        if (shouldShow)
+            statsPanel->count (fileComp->getCurrentFile());
+        else
+            statsPanel->clear();
+
+        statsPanel->setVisible (shouldShow);
+        resized();
+    }
+
+    /** Uses the rules in the user's syntax.rules file if there is one, otherwise a
+        set that suits most log files.
+    */
+    static std::shared_ptr<const SyntaxHighlighter> createHighlighter()
+    {
+        auto rulesFile = juce::File::getSpecialLocation (juce::File::userApplicationDataDirectory)
+                            .getChildFile ("FileReadingTutorial")
+                            .getChildFile ("syntax.rules");
+
+        if (rulesFile.existsAsFile())
+            return std::make_shared<const SyntaxHighlighter> (SyntaxHighlighter::parseRules (rulesFile.loadFileAsString()));
+
+        return std::make_shared<const SyntaxHighlighter> (SyntaxHighlighter::getDefaultRules());
+    }
+
+    /** Saves the timings of the current file as JSON, e.g. to compare builds. */
+    void exportTimings()
+    {
+        timingsChooser.reset (new juce::FileChooser ("Save timings as JSON",
+                                                     juce::File::getSpecialLocation (juce::File::userDocumentsDirectory)
+                                                         .getChildFile ("FileReadingTimings.json"),
+                                                     "*.json"));
+
+        timingsChooser->launchAsync (  juce::FileBrowserComponent::saveMode
+                                     | juce::FileBrowserComponent::canSelectFiles
+                                     | juce::FileBrowserComponent::warnAboutOverwriting,
+                                     [this] (const juce::FileChooser& chooser)
+                                     {
+                                         auto file = chooser.getResult();
+
+                                         if (file != juce::File())
+                                             file.replaceWithText (textView->getTimings().toJSON());
+                                     });
+    }
+
+    /** Compares the current file with another one, side by side. */
+    void chooseFileToDiff()
+    {
+        auto currentFile = fileComp->getCurrentFile();
+
+        if (! currentFile.existsAsFile())
+            return;
+
+        diffChooser.reset (new juce::FileChooser ("Compare " + currentFile.getFileName() + " with", currentFile));
+
+        diffChooser->launchAsync (  juce::FileBrowserComponent::openMode
+                                  | juce::FileBrowserComponent::canSelectFiles,
+                                  [this, currentFile] (const juce::FileChooser& chooser)
+                                  {
+                                      auto otherFile = chooser.getResult();
+
+                                      if (otherFile == juce::File() || ! diffView->compare (currentFile, otherFile))
+                                          return;
+
+                                      textView->setVisible (false);
+                                      diffView->setVisible (true);
+                                      diffButton->setButtonText ("Close diff");
+                                      updateMatchLabel();
+                                  });
+    }
+
+    void closeDiff()
+    {
+        diffView->clear();
+        diffView->setVisible (false);
+        textView->setVisible (true);
+        diffButton->setButtonText ("Diff...");
+        updateMatchLabel();
+    }
+
+    void updateMatchLabel()
+    {
+        if (diffView->isVisible())
+        {
+            matchLabel->setText (diffView->getSummary(), juce::dontSendNotification);
+            return;
+        }
+
+        auto numMatches = (juce::int64) textView->getNumMatches();
+        auto text = juce::String (numMatches) + (numMatches == 1 ? " match" : " matches");
+
+        if (textView->isSearching())
+            text << "...";
+
+        matchLabel->setText (searchBox->isEmpty() ? juce::String() : text, juce::dontSendNotification);
+    }
+
+private:
+    static constexpr size_t memoryLimit = 64 * 1024 * 1024;
+    static constexpr int statsPanelWidth = 300;
+
+    std::unique_ptr<juce::FilenameComponent> fileComp;
+    std::unique_ptr<TextFileView>            textView;
+    std::unique_ptr<juce::ToggleButton>      colourToggle;
+    std::unique_ptr<juce::ToggleButton>      followToggle;
+    std::unique_ptr<juce::ToggleButton>      limitToggle;
+    std::unique_ptr<juce::ToggleButton>      syntaxToggle;
+    std::unique_ptr<juce::ToggleButton>      timingsToggle;
+    std::unique_ptr<juce::TextButton>        exportButton;
+    std::unique_ptr<juce::FileChooser>       timingsChooser;
+    std::unique_ptr<TextDiffView>            diffView;
+    std::unique_ptr<juce::TextButton>        diffButton;
+    std::unique_ptr<juce::FileChooser>       diffChooser;
+    std::unique_ptr<TextStatisticsPanel>     statsPanel;
+    std::unique_ptr<juce::ToggleButton>      statsToggle;
+    std::unique_ptr<juce::TextEditor>        searchBox;
+    std::unique_ptr<juce::TextButton>        previousButton;
+    std::unique_ptr<juce::TextButton>        nextButton;
+    std::unique_ptr<juce::Label>             matchLabel;
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MainContentComponent)
+};
@@ -0,0 +1,157 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE tutorials.
+   Copyright (c) 2020 - Raw Material Software Limited
+
+   The code included in this file is provided under the terms of the ISC license
+   http://www.isc.org/downloads/software-support-policy/isc-license. Permission
+   To use, copy, modify, and/or distribute this software for any purpose with or
+   without fee is hereby granted provided that the above copyright notice and
+   this permission notice appear in all copies.
+
+   THE SOFTWARE IS PROVIDED "AS IS" WITHOUT ANY WARRANTY, AND ALL WARRANTIES,
+   WHETHER EXPRESSED OR IMPLIED, INCLUDING MERCHANTABILITY AND FITNESS FOR
+   PURPOSE, ARE DISCLAIMED.
+
+  ==============================================================================
+*/
+
+/*******************************************************************************
+ The block below describes the properties of this PIP. A PIP is a short snippet
+ of code that can be read by the Projucer and used to generate a JUCE project.
+
+ BEGIN_JUCE_PIP_METADATA
+
+ name:             FileReadingTutorial
+ version:          6.0.0
+ vendor:           JUCE
+ website:          http://juce.com
+ description:      Reads and displays several text files in tabs.
+
+ dependencies:     juce_core, juce_data_structures, juce_events, juce_graphics,
+                   juce_gui_basics
+ exporters:        xcode_mac, vs2019, linux_make
+
+ type:             Component
+ mainClass:        MainContentComponent
+
+ useLocalCopy:     1
+
+ END_JUCE_PIP_METADATA
+
+*******************************************************************************/
+
+
+#pragma once
+
+#include "TextFileView.h"
+
+//==============================================================================
+class MainContentComponent   : public juce::Component,
+                               private juce::Timer
+{
+public:
+    MainContentComponent()
+    {
+        pageCache->setMemoryBudget (pageCacheBudget);  // [1]
+
+        openButton.reset (new juce::TextButton ("Open..."));
+        addAndMakeVisible (openButton.get());
+        openButton->onClick = [this] { chooseFilesToOpen(); };
+
+        closeButton.reset (new juce::TextButton ("Close"));
+        addAndMakeVisible (closeButton.get());
+        closeButton->onClick = [this] { closeCurrentFile(); };
+
+        memoryLabel.reset (new juce::Label());
+        addAndMakeVisible (memoryLabel.get());
+
+        tabs.reset (new juce::TabbedComponent (juce::TabbedButtonBar::TabsAtTop));
+        addAndMakeVisible (tabs.get());
+
+        startTimer (500);
+        setSize (800, 500);
+    }
+
+    void resized() override
+    {
+        openButton->setBounds  (10, 10, 80, 20);
+        closeButton->setBounds (100, 10, 60, 20);
+        memoryLabel->setBounds (170, 10, getWidth() - 180, 20);
+
+        tabs->setBounds (10, 40, getWidth() - 20, getHeight() - 50);
+    }
+
+    void chooseFilesToOpen()
+    {
+        fileChooser.reset (new juce::FileChooser ("Select files to open",
+                                                  juce::File::getSpecialLocation (juce::File::userDocumentsDirectory)));
+
+        fileChooser->launchAsync (  juce::FileBrowserComponent::openMode
+                                  | juce::FileBrowserComponent::canSelectFiles
+                                  | juce::FileBrowserComponent::canSelectMultipleItems,
+                                  [this] (const juce::FileChooser& chooser)
+                                  {
+                                      for (auto& file : chooser.getResults())
+                                          openFile (file);
+                                  });
+    }
+
+    void openFile (const juce::File& file)
+    {
+        // A file that's already open just has its tab brought to the front.
+        for (int i = 0; i < tabs->getNumTabs(); ++i)
+        {
+            if (auto* view = dynamic_cast<TextFileView*> (tabs->getTabContentComponent (i)))
+            {
+                if (view->getFile() == file)
+                {
+                    tabs->setCurrentTabIndex (i);
+                    return;
+                }
+            }
+        }
+
+        std::unique_ptr<TextFileView> view (new TextFileView());
+        view->setMemoryBudget (memoryBudgetPerFile);  // [2]
+
+        if (! view->loadFile (file))
+            return;
+
+        tabs->addTab (file.getFileName(), findColour (juce::ResizableWindow::backgroundColourId),
+                      view.release(), true);  // [3]
+        tabs->setCurrentTabIndex (tabs->getNumTabs() - 1);
+    }
+
+    void closeCurrentFile()
+    {
+        auto index = tabs->getCurrentTabIndex();
+
+        if (index >= 0)
+            tabs->removeTab (index);
+    }
+
+private:
+    void timerCallback() override
+    {
+        memoryLabel->setText ("Pages cached: " + juce::File::descriptionOfSizeInBytes ((juce::int64) pageCache->getMemoryUsage())
+                                + " of " + juce::File::descriptionOfSizeInBytes ((juce::int64) pageCache->getMemoryBudget())
+                                + " for " + juce::String (tabs->getNumTabs()) + " files",
+                              juce::dontSendNotification);
+    }
+
+    static constexpr size_t pageCacheBudget = 128 * 1024 * 1024;
+    static constexpr size_t memoryBudgetPerFile = 16 * 1024 * 1024;
+
+    juce::SharedResourcePointer<SharedPageCache> pageCache;
+
+    std::unique_ptr<juce::TextButton>        openButton;
+    std::unique_ptr<juce::TextButton>        closeButton;
+    std::unique_ptr<juce::Label>             memoryLabel;
+    std::unique_ptr<juce::TabbedComponent>   tabs;
+    std::unique_ptr<juce::FileChooser>       fileChooser;
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MainContentComponent)
+};
@@ -0,0 +1,207 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE tutorials.
+   Copyright (c) 2020 - Raw Material Software Limited
+
+   The code included in this file is provided under the terms of the ISC license
+   http://www.isc.org/downloads/software-support-policy/isc-license. Permission
+   To use, copy, modify, and/or distribute this software for any purpose with or
+   without fee is hereby granted provided that the above copyright notice and
+   this permission notice appear in all copies.
+
+   THE SOFTWARE IS PROVIDED "AS IS" WITHOUT ANY WARRANTY, AND ALL WARRANTIES,
+   WHETHER EXPRESSED OR IMPLIED, INCLUDING MERCHANTABILITY AND FITNESS FOR
+   PURPOSE, ARE DISCLAIMED.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+//==============================================================================
+/**
+    Adds up how long each stage of opening and showing a file takes, and how
+    many bytes each stage handles.
+
+    The stages are timed with the high-resolution tick counter, and the totals
+    are atomics, so the loader thread, its scanning pool and the message thread
+    can all record into the same LoadTimings without locking. A stage that runs
+    on several threads at once reports the sum of their times, which can be
+    longer than the load took.
+
+    The results can be drawn over the view or exported as JSON, so the same file
+    can be compared between builds.
+*/
+class LoadTimings
+{
+public:
+    enum class Stage
+    {
+        open,       // opening or mapping the file and loading any cached index
+        read,       // getting the bytes off disk (or decompressing them)
+        tokenize,   // finding the line and word breaks
+        style,      // colouring the words or classifying the visible lines
+        layout,     // adding the results to the index and working out the lines to show
+        paint,      // drawing the visible lines
+        numStages
+    };
+
+    static constexpr int numStages = (int) Stage::numStages;
+
+    static const char* getName (Stage stage)
+    {
+        switch (stage)
+        {
+            case Stage::open:       return "open";
+            case Stage::read:       return "read";
+            case Stage::tokenize:   return "tokenize";
+            case Stage::style:      return "style";
+            case Stage::layout:     return "layout";
+            case Stage::paint:      return "paint";
+            case Stage::numStages:  break;
+        }
+
+        return {};
+    }
+
+    /** Clears the totals and starts timing the load of a new file. */
+    void reset (const juce::File& file)
+    {
+        for (auto& total : totals)
+        {
+            total.ticks = 0;
+            total.numBytes = 0;
+            total.numCalls = 0;
+        }
+
+        fileName = file.getFullPathName();
+        fileSize = file.getSize();
+        startTicks = juce::Time::getHighResolutionTicks();
+        finishTicks = 0;
+    }
+
+    /** Marks the point at which the whole file has been indexed. */
+    void markFinished()
+    {
+        if (finishTicks == 0)
+            finishTicks = juce::Time::getHighResolutionTicks();
+    }
+
+    void add (Stage stage, juce::int64 ticks, juce::int64 numBytes)
+    {
+        auto& total = totals[(size_t) stage];
+        total.ticks += ticks;
+        total.numBytes += numBytes;
+        ++total.numCalls;
+    }
+
+    double getSeconds (Stage stage) const           { return juce::Time::highResolutionTicksToSeconds (totals[(size_t) stage].ticks); }
+    juce::int64 getNumBytes (Stage stage) const     { return totals[(size_t) stage].numBytes; }
+    juce::int64 getNumCalls (Stage stage) const     { return totals[(size_t) stage].numCalls; }
+
+    /** Returns the time from reset() until the file was indexed, or until now if
+        it's still being loaded.
+    */
+    double getTotalSeconds() const
+    {
+        auto end = finishTicks != 0 ? finishTicks.load() : juce::Time::getHighResolutionTicks();
+        return juce::Time::highResolutionTicksToSeconds (end - startTicks);
+    }
+
+    bool isFinished() const noexcept                { return finishTicks != 0; }
+
+    //==============================================================================
+    /** Returns the totals as a JSON object with one property per stage. */
+    juce::String toJSON() const
+    {
+        auto* stages = new juce::DynamicObject();
+
+        for (int i = 0; i < numStages; ++i)
+        {
+            auto stage = (Stage) i;
+            auto* entry = new juce::DynamicObject();
+            entry->setProperty ("seconds", getSeconds (stage));
+            entry->setProperty ("bytes", getNumBytes (stage));
+            entry->setProperty ("calls", getNumCalls (stage));
+            entry->setProperty ("megabytesPerSecond", getMegabytesPerSecond (stage));
+
+            stages->setProperty (getName (stage), juce::var (entry));
+        }
+
+        auto* root = new juce::DynamicObject();
+        root->setProperty ("file", fileName);
+        root->setProperty ("fileSize", fileSize);
+        root->setProperty ("finished", isFinished());
+        root->setProperty ("totalSeconds", getTotalSeconds());
+        root->setProperty ("stages", juce::var (stages));
+
+        return juce::JSON::toString (juce::var (root));
+    }
+
+    /** Returns one line per stage, for drawing over the view. */
+    juce::StringArray getSummaryLines() const
+    {
+        juce::StringArray lines;
+
+        for (int i = 0; i < numStages; ++i)
+        {
+            auto stage = (Stage) i;
+
+            lines.add (juce::String (getName (stage)).paddedRight (' ', 10)
+                         + juce::String (getSeconds (stage) * 1000.0, 2).paddedLeft (' ', 10) + " ms"
+                         + juce::File::descriptionOfSizeInBytes (getNumBytes (stage)).paddedLeft (' ', 12)
+                         + juce::String (getMegabytesPerSecond (stage), 1).paddedLeft (' ', 10) + " MB/s");
+        }
+
+        lines.add (juce::String ("total").paddedRight (' ', 10)
+                     + juce::String (getTotalSeconds() * 1000.0, 2).paddedLeft (' ', 10) + " ms"
+                     + (isFinished() ? "" : "  (loading)"));
+
+        return lines;
+    }
+
+    //==============================================================================
+    /** Times a stage from construction until destruction. */
+    struct ScopedTimer
+    {
+        ScopedTimer (LoadTimings& t, Stage s, juce::int64 bytes = 0)
+            : timings (t), stage (s), numBytes (bytes),
+              startTicks (juce::Time::getHighResolutionTicks())
+        {
+        }
+
+        ~ScopedTimer()
+        {
+            timings.add (stage, juce::Time::getHighResolutionTicks() - startTicks, numBytes);
+        }
+
+        LoadTimings& timings;
+        Stage stage;
+        juce::int64 numBytes;
+        juce::int64 startTicks;
+
+        JUCE_DECLARE_NON_COPYABLE (ScopedTimer)
+    };
+
+private:
+    double getMegabytesPerSecond (Stage stage) const
+    {
+        auto seconds = getSeconds (stage);
+        return seconds > 0.0 ? (double) getNumBytes (stage) / (1024.0 * 1024.0) / seconds : 0.0;
+    }
+
+    struct Total
+    {
+        std::atomic<juce::int64> ticks { 0 }, numBytes { 0 }, numCalls { 0 };
+    };
+
+    std::array<Total, (size_t) numStages> totals;
+    juce::String fileName;
+    juce::int64 fileSize = 0;
+    juce::int64 startTicks = 0;
+    std::atomic<juce::int64> finishTicks { 0 };
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LoadTimings)
+};
@@ -0,0 +1,179 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE tutorials.
+   Copyright (c) 2020 - Raw Material Software Limited
+
+   The code included in this file is provided under the terms of the ISC license
+   http://www.isc.org/downloads/software-support-policy/isc-license. Permission
+   To use, copy, modify, and/or distribute this software for any purpose with or
+   without fee is hereby granted provided that the above copyright notice and
+   this permission notice appear in all copies.
+
+   THE SOFTWARE IS PROVIDED "AS IS" WITHOUT ANY WARRANTY, AND ALL WARRANTIES,
+   WHETHER EXPRESSED OR IMPLIED, INCLUDING MERCHANTABILITY AND FITNESS FOR
+   PURPOSE, ARE DISCLAIMED.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "TextDataSource.h"
+#include "SharedPageCache.h"
+
+//==============================================================================
+/**
+    A TextDataSource that reads a file a page at a time instead of mapping the
+    whole thing.
+
+    A memory-mapped file looks cheap, but every page that has been looked at
+    counts towards the process's resident memory until the OS decides to drop it.
+    The pages read here are kept in the SharedPageCache instead, whose budget
+    covers every file that's open, and the least recently used page is dropped
+    when another one is needed.
+
+    prefetch() reads the pages just ahead of (or behind) a position on a
+    background thread, so scrolling steadily in one direction rarely has to wait
+    for the disk. getBytes() should only be called from one thread.
+*/
+class PagedTextSource  : public TextDataSource
+{
+public:
+    explicit PagedTextSource (const juce::File& fileToRead)
+        : file (fileToRead),
+          input (fileToRead),
+          size ((size_t) juce::jmax ((juce::int64) 0, fileToRead.getSize()))
+    {
+    }
+
+    ~PagedTextSource() override
+    {
+        prefetchPool.removeAllJobs (true, -1);
+        pageCache->removeAll (ownerId);
+    }
+
+    /** Returns false if the file couldn't be opened (or is empty). */
+    bool openedOk() const noexcept          { return input.openedOk() && size > 0; }
+
+    size_t getSize() const override         { return size; }
+
+    const char* getBytes (juce::Range<juce::int64> range) override
+    {
+        jassert (range.getEnd() <= (juce::int64) size);
+
+        if (range.isEmpty())
+            return static_cast<const char*> (scratch.getData());
+
+        auto firstPage = range.getStart() / (juce::int64) pageSize;
+        auto lastPage  = (range.getEnd() - 1) / (juce::int64) pageSize;
+
+        if (firstPage == lastPage)
+        {
+            currentPage = getPage (firstPage);  // keeps the page alive while the caller has it
+            return currentPage->data.get() + (range.getStart() - firstPage * (juce::int64) pageSize);
+        }
+
+        scratch.ensureSize ((size_t) range.getLength());
+        auto* dest = static_cast<char*> (scratch.getData());
+
+        for (auto pageIndex = firstPage; pageIndex <= lastPage; ++pageIndex)
+        {
+            auto page = getPage (pageIndex);
+            auto pageStart = pageIndex * (juce::int64) pageSize;
+            auto piece = range.getIntersectionWith ({ pageStart, pageStart + (juce::int64) page->size });
+
+            std::memcpy (dest + (piece.getStart() - range.getStart()),
+                         page->data.get() + (piece.getStart() - pageStart),
+                         (size_t) piece.getLength());
+        }
+
+        return dest;
+    }
+
+    /** Starts reading the few pages after a position (or before it, if scrolling
+        backwards) on a background thread.
+    */
+    void prefetch (juce::int64 position, bool forwards)
+    {
+        auto pageIndex = position / (juce::int64) pageSize;
+        auto numPages  = (juce::int64) ((size + pageSize - 1) / pageSize);
+
+        for (juce::int64 i = 1; i <= numPrefetchPages; ++i)
+        {
+            auto pageToRead = forwards ? pageIndex + i : pageIndex - i;
+
+            if (! juce::isPositiveAndBelow (pageToRead, numPages))
+                break;
+
+            if (pageCache->find (ownerId, pageToRead) != nullptr)
+                continue;
+
+            {
+                const juce::ScopedLock sl (prefetchLock);
+
+                if (pagesBeingPrefetched.contains (pageToRead))
+                    continue;
+
+                pagesBeingPrefetched.add (pageToRead);
+            }
+
+            prefetchPool.addJob ([this, pageToRead] { readPageInBackground (pageToRead); });
+        }
+    }
+
+private:
+    //==============================================================================
+    SharedPageCache::PagePtr getPage (juce::int64 pageIndex)
+    {
+        if (auto page = pageCache->find (ownerId, pageIndex))
+            return page;
+
+        return pageCache->insert (ownerId, pageIndex, readPage (input, pageIndex));
+    }
+
+    std::shared_ptr<SharedPageCache::Page> readPage (juce::FileInputStream& stream, juce::int64 pageIndex) const
+    {
+        auto start = pageIndex * (juce::int64) pageSize;
+        auto numBytes = juce::jmin (pageSize, size - (size_t) start);
+        auto page = std::make_shared<SharedPageCache::Page> (numBytes);
+
+        if (stream.setPosition (start))
+            page->size = (size_t) juce::jmax (0, stream.read (page->data, (int) numBytes));
+
+        return page;
+    }
+
+    // The page is read on the prefetch thread, then added to the cache.
+    void readPageInBackground (juce::int64 pageIndex)
+    {
+        auto page = prefetchInput.openedOk() ? readPage (prefetchInput, pageIndex) : nullptr;
+
+        if (page != nullptr && page->size > 0 && pageCache->find (ownerId, pageIndex) == nullptr)
+            pageCache->insert (ownerId, pageIndex, std::move (page));
+
+        const juce::ScopedLock sl (prefetchLock);
+        pagesBeingPrefetched.removeFirstMatchingValue (pageIndex);
+    }
+
+    //==============================================================================
+    static constexpr size_t pageSize = 1024 * 1024;
+    static constexpr juce::int64 numPrefetchPages = 2;
+
+    juce::File file;
+    juce::FileInputStream input;          // used by getBytes()
+    juce::FileInputStream prefetchInput { file };
+    const size_t size;
+
+    juce::SharedResourcePointer<SharedPageCache> pageCache;
+    const juce::uint64 ownerId = pageCache->createOwnerId();
+    SharedPageCache::PagePtr currentPage;
+    juce::MemoryBlock scratch { 1 };
+
+    juce::CriticalSection prefetchLock;
+    juce::Array<juce::int64> pagesBeingPrefetched;
+
+    juce::ThreadPool prefetchPool { 1 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (PagedTextSource)
+};
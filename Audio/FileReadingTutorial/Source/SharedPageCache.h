@@ -0,0 +1,184 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE tutorials.
+   Copyright (c) 2020 - Raw Material Software Limited
+
+   The code included in this file is provided under the terms of the ISC license
+   http://www.isc.org/downloads/software-support-policy/isc-license. Permission
+   To use, copy, modify, and/or distribute this software for any purpose with or
+   without fee is hereby granted provided that the above copyright notice and
+   this permission notice appear in all copies.
+
+   THE SOFTWARE IS PROVIDED "AS IS" WITHOUT ANY WARRANTY, AND ALL WARRANTIES,
+   WHETHER EXPRESSED OR IMPLIED, INCLUDING MERCHANTABILITY AND FITNESS FOR
+   PURPOSE, ARE DISCLAIMED.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+//==============================================================================
+/**
+    One least-recently-used cache of text pages for every file that's open.
+
+    PagedTextSource and CompressedTextSource keep the pages they've read (or
+    decoded) here rather than holding their own, so the memory used for text is
+    limited by a single budget however many files are open. The pages of a file
+    that isn't being looked at are simply the first to go when another file
+    needs room.
+
+    Use it through a juce::SharedResourcePointer, so that everything in the
+    process shares the same instance. Each source takes an owner ID from
+    createOwnerId() to keep its pages apart from everyone else's.
+
+    Pages are handed out as shared pointers, so a page that a source is still
+    reading from stays valid even if it's evicted in the meantime. It just no
+    longer counts towards the budget.
+*/
+class SharedPageCache
+{
+public:
+    struct Page
+    {
+        explicit Page (size_t capacity)     : data (capacity) {}
+
+        juce::HeapBlock<char> data;
+        size_t size = 0;
+    };
+
+    using PagePtr = std::shared_ptr<const Page>;
+
+    SharedPageCache() = default;
+
+    /** Sets the total number of bytes the cached pages may take up. */
+    void setMemoryBudget (size_t numBytes)
+    {
+        const juce::ScopedLock sl (lock);
+        memoryBudget = numBytes;
+        evictUntilWithinBudget();
+    }
+
+    size_t getMemoryBudget() const
+    {
+        const juce::ScopedLock sl (lock);
+        return memoryBudget;
+    }
+
+    /** Returns the number of bytes taken up by the cached pages. */
+    size_t getMemoryUsage() const
+    {
+        const juce::ScopedLock sl (lock);
+        return memoryUsed;
+    }
+
+    /** Returns a new ID for a source to tag its pages with. */
+    juce::uint64 createOwnerId() noexcept       { return ++lastOwnerId; }
+
+    /** Returns a cached page, or null if it isn't there. */
+    PagePtr find (juce::uint64 owner, juce::int64 pageIndex)
+    {
+        const juce::ScopedLock sl (lock);
+        auto found = index.find ({ owner, pageIndex });
+
+        if (found == index.end())
+            return {};
+
+        entries.splice (entries.begin(), entries, found->second);
+        return found->second->page;
+    }
+
+    /** Adds (or replaces) a page, evicting the least recently used pages of any
+        owner if that takes the cache over its budget.
+    */
+    PagePtr insert (juce::uint64 owner, juce::int64 pageIndex, std::shared_ptr<Page> page)
+    {
+        const juce::ScopedLock sl (lock);
+        Key key { owner, pageIndex };
+        auto found = index.find (key);
+
+        if (found != index.end())
+            erase (found);
+
+        memoryUsed += page->size;
+        entries.push_front ({ key, std::move (page) });
+        index[key] = entries.begin();
+
+        evictUntilWithinBudget();
+        return entries.front().page;
+    }
+
+    /** Forgets all of an owner's pages, e.g. when its file is closed. */
+    void removeAll (juce::uint64 owner)
+    {
+        const juce::ScopedLock sl (lock);
+
+        for (auto i = index.begin(); i != index.end();)
+        {
+            if (i->first.owner == owner)
+            {
+                memoryUsed -= i->second->page->size;
+                entries.erase (i->second);
+                i = index.erase (i);
+            }
+            else
+            {
+                ++i;
+            }
+        }
+    }
+
+private:
+    //==============================================================================
+    struct Key
+    {
+        juce::uint64 owner;
+        juce::int64 pageIndex;
+
+        bool operator== (const Key& other) const noexcept   { return owner == other.owner && pageIndex == other.pageIndex; }
+    };
+
+    struct KeyHash
+    {
+        size_t operator() (const Key& key) const noexcept
+        {
+            return (size_t) ((key.owner * 0x9e3779b97f4a7c15ull) ^ (juce::uint64) key.pageIndex);
+        }
+    };
+
+    struct Entry
+    {
+        Key key;
+        PagePtr page;
+    };
+
+    using EntryList = std::list<Entry>;
+
+    void erase (std::unordered_map<Key, EntryList::iterator, KeyHash>::iterator found)
+    {
+        memoryUsed -= found->second->page->size;
+        entries.erase (found->second);
+        index.erase (found);
+    }
+
+    // The page that was just added is never evicted, even if it's bigger than
+    // the whole budget.
+    void evictUntilWithinBudget()
+    {
+        while (memoryUsed > memoryBudget && entries.size() > 1)
+            erase (index.find (entries.back().key));
+    }
+
+    //==============================================================================
+    static constexpr size_t defaultMemoryBudget = 32 * 1024 * 1024;
+
+    juce::CriticalSection lock;
+    EntryList entries;                  // most recently used first
+    std::unordered_map<Key, EntryList::iterator, KeyHash> index;
+    size_t memoryBudget = defaultMemoryBudget;
+    size_t memoryUsed = 0;
+    std::atomic<juce::uint64> lastOwnerId { 0 };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (SharedPageCache)
+};
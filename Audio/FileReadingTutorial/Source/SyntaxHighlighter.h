@@ -0,0 +1,501 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE tutorials.
+   Copyright (c) 2020 - Raw Material Software Limited
+
+   The code included in this file is provided under the terms of the ISC license
+   http://www.isc.org/downloads/software-support-policy/isc-license. Permission
+   To use, copy, modify, and/or distribute this software for any purpose with or
+   without fee is hereby granted provided that the above copyright notice and
+   this permission notice appear in all copies.
+
+   THE SOFTWARE IS PROVIDED "AS IS" WITHOUT ANY WARRANTY, AND ALL WARRANTIES,
+   WHETHER EXPRESSED OR IMPLIED, INCLUDING MERCHANTABILITY AND FITNESS FOR
+   PURPOSE, ARE DISCLAIMED.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "TextStyleRuns.h"
+
+//==============================================================================
+/**
+    Colours text according to a set of rules, compiled into a single DFA.
+
+    There are three kinds of rule:
+     - keyword:  a whole word, e.g. ERROR or return
+     - prefix:   text at the start of a line, which styles the whole line, like
+                 the "*" titles in FileReadingTutorial_02
+     - number:   a decimal, floating point or 0x hex literal
+
+    All the keywords and prefixes are merged into one automaton, and its
+    transitions are stored in a flat table indexed by state and byte class (bytes
+    that every state treats alike share a class). Classifying text is then a
+    single table lookup per byte, whatever the number of rules, plus a little
+    work at the ends of words and lines.
+
+    The automaton always returns to the same state after a newline, so any line
+    can be classified on its own. That means only the lines that are actually on
+    screen ever need to be looked at, however big the file is.
+
+    Rules can be written one per line, as the type, the text, a colour and
+    optionally some styles:
+
+        keyword  ERROR  ffff4040  bold
+        prefix   *      -         bold
+        number   -      ff80c0ff
+
+    where "-" means no text (for numbers) or the default colour. If one prefix
+    starts with another, the shorter one wins.
+*/
+class SyntaxHighlighter
+{
+public:
+    struct Rule
+    {
+        enum class Type
+        {
+            keyword,
+            prefix,
+            number
+        };
+
+        Type type;
+        juce::String text;
+        juce::uint32 colour;    // ARGB, or 0 to use the view's default text colour
+        int fontStyleFlags;
+    };
+
+    /** Where the highlighter has got to, which carries over from one block of text
+        to the next.
+    */
+    struct State
+    {
+        int dfaState;
+        juce::int64 tokenStart, lineStart;
+    };
+
+    explicit SyntaxHighlighter (const std::vector<Rule>& rulesToUse)
+        : rules (rulesToUse)
+    {
+        compile();
+    }
+
+    /** Parses rules written in the format described above, skipping any lines
+        that can't be understood, such as comments.
+    */
+    static std::vector<Rule> parseRules (const juce::String& text)
+    {
+        std::vector<Rule> result;
+
+        for (auto& line : juce::StringArray::fromLines (text))
+        {
+            auto tokens = juce::StringArray::fromTokens (line, true);
+
+            if (tokens.size() < 3)
+                continue;
+
+            Rule rule { Rule::Type::keyword, tokens[1], 0, juce::Font::plain };
+
+            if (tokens[0] == "prefix")       rule.type = Rule::Type::prefix;
+            else if (tokens[0] == "number")  rule.type = Rule::Type::number;
+            else if (tokens[0] != "keyword") continue;
+
+            if (rule.type == Rule::Type::number)
+                rule.text = {};
+
+            if (tokens[2] != "-")
+            {
+                auto colour = juce::Colour::fromString (tokens[2]);
+                rule.colour = (tokens[2].length() <= 6 ? colour.withAlpha (1.0f) : colour).getARGB();
+            }
+
+            for (int i = 3; i < tokens.size(); ++i)
+            {
+                if (tokens[i] == "bold")        rule.fontStyleFlags |= juce::Font::bold;
+                if (tokens[i] == "italic")      rule.fontStyleFlags |= juce::Font::italic;
+                if (tokens[i] == "underlined")  rule.fontStyleFlags |= juce::Font::underlined;
+            }
+
+            if (isValid (rule))
+                result.push_back (rule);
+        }
+
+        return result;
+    }
+
+    /** Some rules for log files, plus FileReadingTutorial_02's titles. */
+    static std::vector<Rule> getDefaultRules()
+    {
+        return parseRules ("prefix   *        -         bold\n"
+                           "prefix   //       ff6a9955  italic\n"
+                           "keyword  FATAL    ffff2020  bold\n"
+                           "keyword  ERROR    ffff4040  bold\n"
+                           "keyword  WARN     ffffb030\n"
+                           "keyword  WARNING  ffffb030\n"
+                           "keyword  INFO     ff60c060\n"
+                           "keyword  DEBUG    ff8080ff\n"
+                           "keyword  TRACE    ff909090\n"
+                           "number   -        ff80c0ff\n");
+    }
+
+    /** Returns the state to use for text that begins at the start of a line. */
+    State startLine (juce::int64 lineStart) const noexcept
+    {
+        return { lineStartState, lineStart, lineStart };
+    }
+
+    /** Classifies a block of text, adding a run to the given TextStyleRuns wherever
+        the style changes.
+    */
+    void highlight (const char* data, size_t numBytes, juce::int64 baseOffset,
+                    State& state, TextStyleRuns& runs) const
+    {
+        auto dfaState = state.dfaState;
+        auto numClasses = (size_t) numByteClasses;
+
+        for (size_t i = 0; i < numBytes; ++i)
+        {
+            auto entry = transitions[(size_t) dfaState * numClasses + byteClasses[(juce::uint8) data[i]]];
+            auto next = (int) (entry & 0xffff);
+
+            if (auto actions = entry >> 16)
+                performActions (actions, dfaState, next, baseOffset + (juce::int64) i, state, runs);
+
+            dfaState = next;
+        }
+
+        state.dfaState = dfaState;
+    }
+
+    /** Styles a word that runs right up to the end of the text. */
+    void finish (State& state, juce::int64 endOffset, TextStyleRuns& runs) const
+    {
+        auto& info = states[(size_t) state.dfaState];
+
+        if (info.isToken && info.rule >= 0)
+            addTokenRuns (state.tokenStart, endOffset, info.rule, runs);
+    }
+
+    int getNumStates() const noexcept               { return (int) states.size(); }
+    int getNumByteClasses() const noexcept          { return numByteClasses; }
+
+private:
+    //==============================================================================
+    enum Action
+    {
+        startToken    = 1,
+        endToken      = 2,
+        enterLineRule = 4,
+        leaveLineRule = 8,
+        newLine       = 16
+    };
+
+    struct StateInfo
+    {
+        bool isToken = false, inLineRule = false;
+        int rule = -1;      // the rule for a token that ends here, or the prefix rule
+    };
+
+    struct TrieNode
+    {
+        std::map<juce::uint8, int> children;
+        int rule = -1, state = -1, wordState = -1;
+    };
+
+    static bool isWordByte (juce::uint8 c) noexcept
+    {
+        return juce::CharacterFunctions::isLetterOrDigit ((char) c) || c == '_' || c >= 0x80;
+    }
+
+    static bool isDigit (juce::uint8 c) noexcept      { return c >= '0' && c <= '9'; }
+    static bool isHexDigit (juce::uint8 c) noexcept   { return juce::CharacterFunctions::getHexDigitValue (c) >= 0; }
+
+    static bool isValid (const Rule& rule)
+    {
+        if (rule.type == Rule::Type::number)
+            return true;
+
+        auto* text = rule.text.toRawUTF8();
+
+        if (rule.text.isEmpty() || rule.text.containsChar ('\n'))
+            return false;
+
+        if (rule.type == Rule::Type::keyword)
+        {
+            if (isDigit ((juce::uint8) text[0]))
+                return false;
+
+            for (auto* c = text; *c != 0; ++c)
+                if (! isWordByte ((juce::uint8) *c))
+                    return false;
+        }
+
+        return true;
+    }
+
+    //==============================================================================
+    void performActions (juce::uint32 actions, int from, int to, juce::int64 position,
+                         State& state, TextStyleRuns& runs) const
+    {
+        if ((actions & endToken) != 0 && states[(size_t) from].rule >= 0)
+            addTokenRuns (state.tokenStart, position, states[(size_t) from].rule, runs);
+
+        if ((actions & startToken) != 0)
+            state.tokenStart = position;
+
+        if ((actions & enterLineRule) != 0)
+        {
+            // Anything already found on this line is overridden.
+            auto& rule = rules[(size_t) states[(size_t) to].rule];
+            runs.truncate (state.lineStart);
+            runs.addRun ({ state.lineStart, rule.colour, rule.fontStyleFlags });
+        }
+
+        if ((actions & leaveLineRule) != 0)
+            runs.addRun ({ position, 0, juce::Font::plain });
+
+        if ((actions & newLine) != 0)
+            state.lineStart = position + 1;
+    }
+
+    void addTokenRuns (juce::int64 start, juce::int64 end, int ruleIndex, TextStyleRuns& runs) const
+    {
+        auto& rule = rules[(size_t) ruleIndex];
+        runs.addRun ({ start, rule.colour, rule.fontStyleFlags });
+        runs.addRun ({ end, 0, juce::Font::plain });
+    }
+
+    //==============================================================================
+    int addState (bool isToken, bool inLineRule, int rule)
+    {
+        states.push_back ({ isToken, inLineRule, rule });
+        return (int) states.size() - 1;
+    }
+
+    static int addToTrie (std::vector<TrieNode>& trie, const juce::String& text, int rule)
+    {
+        int node = 0;
+
+        for (auto* c = text.toRawUTF8(); *c != 0; ++c)
+        {
+            auto byte = (juce::uint8) *c;
+            auto child = trie[(size_t) node].children.find (byte);
+
+            if (child == trie[(size_t) node].children.end())
+            {
+                trie.emplace_back();
+                child = trie[(size_t) node].children.insert ({ byte, (int) trie.size() - 1 }).first;
+            }
+
+            node = child->second;
+        }
+
+        if (trie[(size_t) node].rule < 0)
+            trie[(size_t) node].rule = rule;
+
+        return node;
+    }
+
+    // Builds the automaton in two layers: a word layer that recognises keywords
+    // and numbers anywhere in a line, and a layer for the prefixes on top of it,
+    // where each prefix state also remembers which word state the same text would
+    // have led to, so nothing is lost when a prefix fails to match.
+    void compile()
+    {
+        std::vector<TrieNode> keywords (1), prefixes (1);
+        auto numberRule = -1;
+
+        for (int i = 0; i < (int) rules.size(); ++i)
+        {
+            jassert (isValid (rules[(size_t) i]));
+
+            switch (rules[(size_t) i].type)
+            {
+                case Rule::Type::keyword:  addToTrie (keywords, rules[(size_t) i].text, i); break;
+                case Rule::Type::prefix:   addToTrie (prefixes, rules[(size_t) i].text, i); break;
+                case Rule::Type::number:   if (numberRule < 0) numberRule = i; break;
+            }
+        }
+
+        lineStartState = addState (false, false, -1);
+        betweenState   = addState (false, false, -1);
+        plainWordState = addState (true, false, -1);
+        zeroState      = addState (true, false, numberRule);
+        decimalState   = addState (true, false, numberRule);
+        fractionState  = addState (true, false, numberRule);
+        hexPrefixState = addState (true, false, -1);
+        hexState       = addState (true, false, numberRule);
+        lineRuleState  = addState (false, true, -1);
+
+        keywords[0].state = betweenState;
+        keywordNodeForState.assign (states.size() + keywords.size(), -1);
+
+        for (size_t i = 1; i < keywords.size(); ++i)
+        {
+            keywords[i].state = addState (true, false, keywords[i].rule);
+            keywordNodeForState[(size_t) keywords[i].state] = (int) i;
+        }
+
+        // Each prefix node's word state is the word layer's state after its text.
+        prefixes[0].state = lineStartState;
+        prefixes[0].wordState = betweenState;
+
+        for (size_t i = 0; i < prefixes.size(); ++i)
+        {
+            for (auto& child : prefixes[i].children)
+            {
+                auto& node = prefixes[(size_t) child.second];
+                node.wordState = getWordTransition (keywords, prefixes[i].wordState, child.first);
+
+                auto& wordInfo = states[(size_t) node.wordState];
+                node.state = node.rule >= 0 ? addState (false, true, node.rule)
+                                            : addState (wordInfo.isToken, false, wordInfo.rule);
+            }
+        }
+
+        jassert (states.size() < 0x10000);
+
+        // Works out every transition for every byte...
+        std::vector<int> prefixNodeForState (states.size(), -1);
+
+        for (size_t i = 0; i < prefixes.size(); ++i)
+            prefixNodeForState[(size_t) prefixes[i].state] = (int) i;
+
+        std::vector<juce::uint32> columns (256 * states.size());
+
+        for (size_t s = 0; s < states.size(); ++s)
+        {
+            for (int byte = 0; byte < 256; ++byte)
+            {
+                auto c = (juce::uint8) byte;
+                int next;
+
+                auto prefixNode = prefixNodeForState[s];
+
+                if (prefixNode >= 0)
+                {
+                    auto& node = prefixes[(size_t) prefixNode];
+                    auto child = node.children.find (c);
+
+                    if (node.rule >= 0)
+                        next = c == '\n' ? lineStartState : lineRuleState;
+                    else if (child != node.children.end())
+                        next = prefixes[(size_t) child->second].state;
+                    else
+                        next = getWordTransition (keywords, node.wordState, c);
+                }
+                else if ((int) s == lineRuleState)
+                {
+                    next = c == '\n' ? lineStartState : lineRuleState;
+                }
+                else
+                {
+                    next = getWordTransition (keywords, (int) s, c);
+                }
+
+                columns[(size_t) byte * states.size() + s] = (juce::uint32) next
+                                                             | (getActions ((int) s, next, c) << 16);
+            }
+        }
+
+        // ...then merges the bytes whose transitions are identical into classes.
+        std::map<std::vector<juce::uint32>, int> classes;
+
+        for (int byte = 0; byte < 256; ++byte)
+        {
+            auto columnStart = columns.begin() + (std::ptrdiff_t) ((size_t) byte * states.size());
+            std::vector<juce::uint32> column (columnStart, columnStart + (std::ptrdiff_t) states.size());
+
+            auto result = classes.insert ({ std::move (column), (int) classes.size() });
+            byteClasses[(size_t) byte] = (juce::uint8) result.first->second;
+        }
+
+        numByteClasses = (int) classes.size();
+        transitions.resize (states.size() * (size_t) numByteClasses);
+
+        for (auto& c : classes)
+            for (size_t s = 0; s < states.size(); ++s)
+                transitions[s * (size_t) numByteClasses + (size_t) c.second] = c.first[s];
+
+        keywordNodeForState.clear();
+    }
+
+    int getWordTransition (const std::vector<TrieNode>& keywords, int state, juce::uint8 c) const
+    {
+        if (c == '\n')
+            return lineStartState;
+
+        if (states[(size_t) state].isToken && isWordByte (c))
+        {
+            if (state == plainWordState)
+                return plainWordState;
+
+            if (state == zeroState && (c == 'x' || c == 'X'))
+                return hexPrefixState;
+
+            if (state == zeroState || state == decimalState)
+                return isDigit (c) ? decimalState : plainWordState;
+
+            if (state == fractionState)
+                return isDigit (c) ? fractionState : plainWordState;
+
+            if (state == hexPrefixState || state == hexState)
+                return isHexDigit (c) ? hexState : plainWordState;
+
+            auto& node = keywords[(size_t) keywordNodeForState[(size_t) state]];
+            auto child = node.children.find (c);
+            return child != node.children.end() ? keywords[(size_t) child->second].state : plainWordState;
+        }
+
+        if (c == '.' && (state == zeroState || state == decimalState))
+            return fractionState;
+
+        // Otherwise a word has ended (or never started).
+        if (isDigit (c))
+            return c == '0' ? zeroState : decimalState;
+
+        if (isWordByte (c))
+        {
+            auto child = keywords[0].children.find (c);
+            return child != keywords[0].children.end() ? keywords[(size_t) child->second].state : plainWordState;
+        }
+
+        return betweenState;
+    }
+
+    juce::uint32 getActions (int from, int to, juce::uint8 c) const
+    {
+        auto& source = states[(size_t) from];
+        auto& dest   = states[(size_t) to];
+        juce::uint32 actions = c == '\n' ? newLine : 0;
+
+        if (dest.inLineRule || source.inLineRule)
+        {
+            if (dest.inLineRule && ! source.inLineRule)   actions |= enterLineRule;
+            if (source.inLineRule && ! dest.inLineRule)   actions |= leaveLineRule;
+            return actions;
+        }
+
+        if (source.isToken && ! dest.isToken)   actions |= endToken;
+        if (dest.isToken && ! source.isToken)   actions |= startToken;
+
+        return actions;
+    }
+
+    //==============================================================================
+    std::vector<Rule> rules;
+    std::vector<StateInfo> states;
+    std::vector<int> keywordNodeForState;    // only needed while compiling
+    std::vector<juce::uint32> transitions;   // the next state, with the actions in the top 16 bits
+    std::array<juce::uint8, 256> byteClasses {};
+    int numByteClasses = 0;
+
+    int lineStartState = 0, betweenState = 0, plainWordState = 0, zeroState = 0, decimalState = 0,
+        fractionState = 0, hexPrefixState = 0, hexState = 0, lineRuleState = 0;
+
+    JUCE_LEAK_DETECTOR (SyntaxHighlighter)
+};
@@ -0,0 +1,76 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE tutorials.
+   Copyright (c) 2020 - Raw Material Software Limited
+
+   The code included in this file is provided under the terms of the ISC license
+   http://www.isc.org/downloads/software-support-policy/isc-license. Permission
+   To use, copy, modify, and/or distribute this software for any purpose with or
+   without fee is hereby granted provided that the above copyright notice and
+   this permission notice appear in all copies.
+
+   THE SOFTWARE IS PROVIDED "AS IS" WITHOUT ANY WARRANTY, AND ALL WARRANTIES,
+   WHETHER EXPRESSED OR IMPLIED, INCLUDING MERCHANTABILITY AND FITNESS FOR
+   PURPOSE, ARE DISCLAIMED.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+//==============================================================================
+/**
+    Supplies the bytes of a text that may be far too big to hold in memory.
+
+    TextFileView and TextFileLoader only ever ask for short ranges (a line or
+    less), so a source is free to produce them however it likes: straight out of
+    a memory-mapped file, or by decompressing part of a compressed one.
+
+    A source is used by one thread at a time.
+*/
+class TextDataSource
+{
+public:
+    virtual ~TextDataSource() = default;
+
+    /** Returns the number of bytes that are currently available. */
+    virtual size_t getSize() const = 0;
+
+    /** Returns the bytes in a range that lies within getSize(). The pointer stays
+        valid until getBytes() is called again.
+    */
+    virtual const char* getBytes (juce::Range<juce::int64> range) = 0;
+};
+
+//==============================================================================
+/** A TextDataSource that simply maps the whole file into memory. */
+class MappedTextSource  : public TextDataSource
+{
+public:
+    explicit MappedTextSource (const juce::File& file)
+        : mapping (file, juce::MemoryMappedFile::readOnly)
+    {
+    }
+
+    /** Returns false if the file couldn't be mapped (e.g. it's empty). */
+    bool openedOk() const noexcept      { return mapping.getData() != nullptr; }
+
+    const char* getData() const noexcept
+    {
+        return static_cast<const char*> (mapping.getData());
+    }
+
+    size_t getSize() const override     { return mapping.getSize(); }
+
+    const char* getBytes (juce::Range<juce::int64> range) override
+    {
+        jassert (range.getEnd() <= (juce::int64) getSize());
+        return getData() + range.getStart();
+    }
+
+private:
+    juce::MemoryMappedFile mapping;
+
+    JUCE_DECLARE_NON_COPYABLE (MappedTextSource)
+};
@@ -0,0 +1,339 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE tutorials.
+   Copyright (c) 2020 - Raw Material Software Limited
+
+   The code included in this file is provided under the terms of the ISC license
+   http://www.isc.org/downloads/software-support-policy/isc-license. Permission
+   To use, copy, modify, and/or distribute this software for any purpose with or
+   without fee is hereby granted provided that the above copyright notice and
+   this permission notice appear in all copies.
+
+   THE SOFTWARE IS PROVIDED "AS IS" WITHOUT ANY WARRANTY, AND ALL WARRANTIES,
+   WHETHER EXPRESSED OR IMPLIED, INCLUDING MERCHANTABILITY AND FITNESS FOR
+   PURPOSE, ARE DISCLAIMED.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "TextFileDiff.h"
+#include "TextLineIndex.h"
+
+//==============================================================================
+/**
+    Shows two text files side by side, with the lines that differ highlighted.
+
+    The files are compared by a TextFileDiff. The view never builds a list of
+    its rows: a row is mapped to a line on each side by a binary search of the
+    hunks, with the unchanged lines in between pairing up one to one. So only
+    the hunks in the visible rows are ever drawn, and the view needs the same
+    memory for two large files as for two small ones with the same hunks.
+
+    Where one side of a hunk has fewer lines than the other, its extra rows are
+    left empty so that the text below stays aligned.
+*/
+class TextDiffView  : public juce::Component,
+                      private juce::ScrollBar::Listener
+{
+public:
+    TextDiffView()
+    {
+        addAndMakeVisible (verticalScrollBar);
+        verticalScrollBar.setAutoHide (false);
+        verticalScrollBar.setSingleStepSize (1.0);
+        verticalScrollBar.addListener (this);
+
+        diff.onFinished = [this]
+        {
+            indexHunks();
+            updateScrollBar();
+            repaint();
+
+            if (onFinished != nullptr)
+                onFinished();
+        };
+
+        setWantsKeyboardFocus (true);
+    }
+
+    ~TextDiffView() override
+    {
+        verticalScrollBar.removeListener (this);
+    }
+
+    /** Starts comparing two files in the background. Returns false if they can't be compared. */
+    bool compare (const juce::File& firstFile, const juce::File& secondFile)
+    {
+        clear();
+        auto started = diff.start (firstFile, secondFile);
+
+        repaint();
+        return started;
+    }
+
+    void clear()
+    {
+        diff.cancel();
+        hunkRowStarts.clear();
+        numRows = 0;
+        verticalScrollBar.setCurrentRangeStart (0.0);
+
+        updateScrollBar();
+        repaint();
+    }
+
+    bool isComparing() const                { return diff.isComparing(); }
+
+    /** Returns a one-line description of the differences, e.g. for a label. */
+    juce::String getSummary() const
+    {
+        if (! diff.isFinished())
+            return diff.isComparing() ? "Comparing..." : juce::String();
+
+        juce::int64 numRemoved = 0, numAdded = 0;
+
+        for (auto& hunk : diff.getHunks())
+        {
+            numRemoved += hunk.numA;
+            numAdded += hunk.numB;
+        }
+
+        auto numHunks = (juce::int64) diff.getHunks().size();
+
+        return juce::String (numHunks) + (numHunks == 1 ? " hunk, -" : " hunks, -")
+                 + juce::String (numRemoved) + " +" + juce::String (numAdded)
+                 + " in " + juce::String (diff.getSecondsTaken(), 2) + " s";
+    }
+
+    /** Scrolls to the next hunk below the top of the view, wrapping round at the end. */
+    bool nextHunk()                         { return moveToHunk (true); }
+
+    /** Scrolls to the previous hunk, wrapping round at the start. */
+    bool previousHunk()                     { return moveToHunk (false); }
+
+    /** Called when a comparison has finished. */
+    std::function<void()> onFinished;
+
+    //==============================================================================
+    void paint (juce::Graphics& g) override
+    {
+        g.fillAll (findColour (juce::TextEditor::backgroundColourId));
+        g.setFont (font);
+
+        auto area = getLocalBounds().withTrimmedRight (verticalScrollBar.getWidth());
+        auto header = area.removeFromTop (getLineHeight() + 6);
+        auto panes = getPanes (area);
+
+        g.setColour (findColour (juce::TextEditor::textColourId));
+
+        for (int side = 0; side < 2; ++side)
+            g.drawText (diff.getFile (side).getFileName(), header.withX (panes[side].getX()).withWidth (panes[side].getWidth()),
+                        juce::Justification::centredLeft, true);
+
+        if (! diff.isFinished())
+        {
+            if (diff.isComparing())
+                g.drawText ("Comparing...", area, juce::Justification::centred, false);
+
+            return;
+        }
+
+        auto firstRow = getFirstVisibleRow();
+        auto lastRow  = juce::jmin (numRows, firstRow + getNumVisibleRows() + 1);
+        auto lineHeight = getLineHeight();
+
+        for (int side = 0; side < 2; ++side)
+        {
+            juce::Graphics::ScopedSaveState saveState (g);
+            g.reduceClipRegion (panes[side]);
+
+            auto y = panes[side].getY();
+
+            for (auto row = firstRow; row < lastRow; ++row, y += lineHeight)
+            {
+                auto rowLines = getRow (row);
+                drawLine (g, side, side == 0 ? rowLines.lineA : rowLines.lineB, rowLines.changed,
+                          panes[side].withY (y).withHeight (lineHeight));
+            }
+        }
+    }
+
+    void resized() override
+    {
+        auto scrollBarWidth = getLookAndFeel().getDefaultScrollbarWidth();
+        verticalScrollBar.setBounds (getLocalBounds().removeFromRight (scrollBarWidth)
+                                                     .withTrimmedTop (getLineHeight() + 6));
+
+        updateScrollBar();
+    }
+
+    void mouseWheelMove (const juce::MouseEvent& e, const juce::MouseWheelDetails& wheel) override
+    {
+        verticalScrollBar.mouseWheelMove (e, wheel);
+    }
+
+    bool keyPressed (const juce::KeyPress& key) override
+    {
+        return verticalScrollBar.keyPressed (key);
+    }
+
+private:
+    // The lines shown in a row, or -1 where a side has no line.
+    struct RowLines
+    {
+        juce::int64 lineA, lineB;
+        bool changed;
+    };
+
+    // Works out the row at which each hunk starts. Each hunk takes as many rows
+    // as its longer side, so the rows get ahead of the first file's lines by the
+    // number of lines that hunks have added.
+    void indexHunks()
+    {
+        hunkRowStarts.clear();
+        juce::int64 extraRows = 0;
+
+        for (auto& hunk : diff.getHunks())
+        {
+            hunkRowStarts.push_back (hunk.startA + extraRows);
+            extraRows += juce::jmax (hunk.numA, hunk.numB) - hunk.numA;
+        }
+
+        numRows = diff.getNumLines (0) + extraRows;
+    }
+
+    RowLines getRow (juce::int64 row) const
+    {
+        auto next = std::upper_bound (hunkRowStarts.begin(), hunkRowStarts.end(), row);
+
+        if (next == hunkRowStarts.begin())
+            return { row, row, false };
+
+        auto index = (size_t) (next - hunkRowStarts.begin()) - 1;
+        auto& hunk = diff.getHunks()[index];
+        auto offset = row - hunkRowStarts[index];
+        auto numHunkRows = juce::jmax (hunk.numA, hunk.numB);
+
+        if (offset < numHunkRows)
+            return { offset < hunk.numA ? hunk.startA + offset : -1,
+                     offset < hunk.numB ? hunk.startB + offset : -1,
+                     true };
+
+        offset -= numHunkRows;
+        return { hunk.startA + hunk.numA + offset, hunk.startB + hunk.numB + offset, false };
+    }
+
+    void drawLine (juce::Graphics& g, int side, juce::int64 line, bool changed, juce::Rectangle<int> area) const
+    {
+        if (line < 0)
+        {
+            g.setColour (findColour (juce::TextEditor::textColourId).withAlpha (0.06f));
+            g.fillRect (area);
+            return;
+        }
+
+        if (changed)
+        {
+            g.setColour ((side == 0 ? juce::Colours::red : juce::Colours::green).withAlpha (0.25f));
+            g.fillRect (area);
+        }
+
+        auto gutter = area.removeFromLeft (getGutterWidth());
+        auto range = getDisplayedRange (side, line);
+
+        g.setColour (findColour (juce::TextEditor::textColourId).withAlpha (0.5f));
+        g.drawText (juce::String (line + 1), gutter.withTrimmedRight (6), juce::Justification::centredRight, false);
+
+        g.setColour (findColour (juce::TextEditor::textColourId));
+        g.drawText (juce::String::fromUTF8 (diff.getBytes (side, range), (int) range.getLength()),
+                    area, juce::Justification::centredLeft, false);
+    }
+
+    // Like TextFileView, long lines are cut short and line endings are left out.
+    juce::Range<juce::int64> getDisplayedRange (int side, juce::int64 line) const
+    {
+        return TextLineIndex::getDisplayedRange (diff.getLineRange (side, line),
+                                                 [&] (juce::Range<juce::int64> range) { return diff.getBytes (side, range); });
+    }
+
+    bool moveToHunk (bool forward)
+    {
+        auto numHunks = hunkRowStarts.size();
+
+        if (numHunks == 0)
+            return false;
+
+        auto topOfView = getFirstVisibleRow() + contextRows;
+        size_t index;
+
+        if (forward)
+        {
+            index = (size_t) (std::upper_bound (hunkRowStarts.begin(), hunkRowStarts.end(), topOfView) - hunkRowStarts.begin());
+            index = index < numHunks ? index : 0;
+        }
+        else
+        {
+            index = (size_t) (std::lower_bound (hunkRowStarts.begin(), hunkRowStarts.end(), topOfView) - hunkRowStarts.begin());
+            index = index > 0 ? index - 1 : numHunks - 1;
+        }
+
+        verticalScrollBar.setCurrentRangeStart ((double) juce::jmax ((juce::int64) 0, hunkRowStarts[index] - contextRows));
+        return true;
+    }
+
+    void scrollBarMoved (juce::ScrollBar*, double) override
+    {
+        repaint();
+    }
+
+    void updateScrollBar()
+    {
+        auto numVisible = (double) getNumVisibleRows();
+
+        verticalScrollBar.setRangeLimits (0.0, juce::jmax ((double) numRows, numVisible));
+        verticalScrollBar.setCurrentRange (verticalScrollBar.getCurrentRangeStart(), numVisible);
+    }
+
+    std::array<juce::Rectangle<int>, 2> getPanes (juce::Rectangle<int> area) const
+    {
+        area.reduce (4, 2);
+        auto left = area.removeFromLeft ((area.getWidth() - paneGap) / 2);
+        area.removeFromLeft (paneGap);
+
+        return { { left, area } };
+    }
+
+    juce::int64 getFirstVisibleRow() const  { return (juce::int64) verticalScrollBar.getCurrentRangeStart(); }
+
+    int getNumVisibleRows() const
+    {
+        return juce::jmax (1, (getHeight() - getLineHeight() - 10) / getLineHeight());
+    }
+
+    int getLineHeight() const
+    {
+        return juce::jmax (1, (int) std::ceil (font.getHeight()));
+    }
+
+    int getGutterWidth() const
+    {
+        auto maxLines = diff.isFinished() ? juce::jmax (diff.getNumLines (0), diff.getNumLines (1)) : 0;
+        return font.getStringWidth (juce::String (maxLines)) + 12;
+    }
+
+    static constexpr juce::int64 contextRows = 3;
+    static constexpr int paneGap = 8;
+
+    TextFileDiff diff;
+    std::vector<juce::int64> hunkRowStarts;
+    juce::int64 numRows = 0;
+
+    juce::Font font { juce::Font::getDefaultMonospacedFontName(), 14.0f, juce::Font::plain };
+    juce::ScrollBar verticalScrollBar { true };
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TextDiffView)
+};
@@ -0,0 +1,254 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE tutorials.
+   Copyright (c) 2020 - Raw Material Software Limited
+
+   The code included in this file is provided under the terms of the ISC license
+   http://www.isc.org/downloads/software-support-policy/isc-license. Permission
+   To use, copy, modify, and/or distribute this software for any purpose with or
+   without fee is hereby granted provided that the above copyright notice and
+   this permission notice appear in all copies.
+
+   THE SOFTWARE IS PROVIDED "AS IS" WITHOUT ANY WARRANTY, AND ALL WARRANTIES,
+   WHETHER EXPRESSED OR IMPLIED, INCLUDING MERCHANTABILITY AND FITNESS FOR
+   PURPOSE, ARE DISCLAIMED.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "TextDataSource.h"
+#include "TextLineDiff.h"
+#include "CompressedTextSource.h"
+
+//==============================================================================
+/**
+    Compares two text files line by line on a background thread.
+
+    Both files are mapped and cut into blocks, and the lines in each block are
+    found and hashed by a job on a thread pool, so the hashing runs on all the
+    cores. TextLineDiff then works out the hunks from the hashes alone. Only the
+    line offsets are kept afterwards, so the memory used depends on the number
+    of lines rather than the size of the files.
+
+    The results are handed to the message thread when the comparison is done,
+    and onFinished is called. Compressed files aren't supported.
+*/
+class TextFileDiff  : private juce::Thread,
+                      private juce::AsyncUpdater
+{
+public:
+    TextFileDiff()
+        : juce::Thread ("TextFileDiff")
+    {
+    }
+
+    ~TextFileDiff() override
+    {
+        cancel();
+    }
+
+    /** Starts comparing two files, cancelling any comparison in progress. Returns
+        false if either file can't be compared.
+    */
+    bool start (const juce::File& firstFile, const juce::File& secondFile)
+    {
+        cancel();
+
+        for (auto& file : { firstFile, secondFile })
+            if (! file.existsAsFile() || CompressedTextSource::isSupported (CompressedTextSource::detectFormat (file)))
+                return false;
+
+        files[0] = firstFile;
+        files[1] = secondFile;
+        startTicks = juce::Time::getHighResolutionTicks();
+
+        startThread();
+        return true;
+    }
+
+    /** Stops any comparison in progress and forgets the results. */
+    void cancel()
+    {
+        stopThread (stopTimeoutMs);
+        cancelPendingUpdate();
+
+        {
+            const juce::ScopedLock sl (pendingLock);
+            pendingResult.reset();
+        }
+
+        result.reset();
+        files[0] = files[1] = juce::File();
+    }
+
+    bool isComparing() const                { return isThreadRunning() || (result == nullptr && files[0] != juce::File()); }
+    bool isFinished() const noexcept        { return result != nullptr; }
+
+    const juce::File& getFile (int side) const noexcept     { return files[side]; }
+
+    //==============================================================================
+    /** The rest of these can only be used once the comparison has finished. */
+    const std::vector<TextLineDiff::Hunk>& getHunks() const noexcept    { return result->hunks; }
+
+    juce::int64 getNumLines (int side) const noexcept
+    {
+        return (juce::int64) result->sides[side].lineStarts.size();
+    }
+
+    /** Returns the byte range of a line, including its line ending. */
+    juce::Range<juce::int64> getLineRange (int side, juce::int64 line) const
+    {
+        auto& lineStarts = result->sides[side].lineStarts;
+        auto end = (size_t) line + 1 < lineStarts.size() ? lineStarts[(size_t) line + 1]
+                                                         : (juce::int64) result->sides[side].getSize();
+
+        return { lineStarts[(size_t) line], end };
+    }
+
+    const char* getBytes (int side, juce::Range<juce::int64> range) const
+    {
+        return result->sides[side].mapping->getBytes (range);
+    }
+
+    /** Returns how long the comparison took, including hashing. */
+    double getSecondsTaken() const noexcept     { return result->secondsTaken; }
+
+    /** Called on the message thread when the comparison has finished. */
+    std::function<void()> onFinished;
+
+private:
+    //==============================================================================
+    struct Side
+    {
+        size_t getSize() const                  { return mapping != nullptr ? mapping->getSize() : 0; }
+
+        std::shared_ptr<MappedTextSource> mapping;    // null for an empty file
+        std::vector<juce::int64> lineStarts;
+        std::vector<juce::uint64> hashes;             // dropped once the diff is done
+    };
+
+    struct Result
+    {
+        Side sides[2];
+        std::vector<TextLineDiff::Hunk> hunks;
+        double secondsTaken = 0.0;
+    };
+
+    // Hashes the lines in one block of a file.
+    struct Job
+    {
+        int side = 0;
+        size_t start = 0, end = 0;
+        std::vector<juce::int64> lineStarts;
+        std::vector<juce::uint64> hashes;
+        juce::WaitableEvent finished;
+    };
+
+    //==============================================================================
+    void run() override
+    {
+        std::unique_ptr<Result> newResult (new Result());
+
+        for (int side = 0; side < 2; ++side)
+        {
+            auto mapping = std::make_shared<MappedTextSource> (files[side]);
+
+            if (mapping->openedOk())
+                newResult->sides[side].mapping = std::move (mapping);
+        }
+
+        if (! hashLines (*newResult))
+            return;
+
+        newResult->hunks = TextLineDiff::compare (newResult->sides[0].hashes, newResult->sides[1].hashes,
+                                                  [this] { return threadShouldExit(); });
+
+        if (threadShouldExit())
+            return;
+
+        for (auto& side : newResult->sides)
+            std::vector<juce::uint64>().swap (side.hashes);
+
+        newResult->secondsTaken = juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - startTicks);
+
+        {
+            const juce::ScopedLock sl (pendingLock);
+            pendingResult = std::move (newResult);
+        }
+
+        triggerAsyncUpdate();
+    }
+
+    bool hashLines (Result& newResult)
+    {
+        std::vector<std::unique_ptr<Job>> jobs;
+        juce::ThreadPool pool (juce::jmin (juce::SystemStats::getNumCpus(), maximumHashThreads));
+
+        for (int side = 0; side < 2; ++side)
+        {
+            auto& mapping = newResult.sides[side].mapping;
+
+            if (mapping == nullptr)
+                continue;
+
+            for (size_t start = 0; start < mapping->getSize(); start += blockSize)
+            {
+                jobs.emplace_back (new Job());
+                auto* job = jobs.back().get();
+                job->side = side;
+                job->start = start;
+                job->end = juce::jmin (start + blockSize, mapping->getSize());
+
+                pool.addJob ([this, job, data = mapping->getData(), size = mapping->getSize()]
+                {
+                    if (! threadShouldExit())
+                        TextLineDiff::hashLines (data, size, job->start, job->end, job->lineStarts, job->hashes);
+
+                    job->finished.signal();
+                });
+            }
+        }
+
+        // The blocks are added in file order as they finish.
+        for (auto& job : jobs)
+        {
+            job->finished.wait();
+
+            auto& side = newResult.sides[job->side];
+            side.lineStarts.insert (side.lineStarts.end(), job->lineStarts.begin(), job->lineStarts.end());
+            side.hashes.insert (side.hashes.end(), job->hashes.begin(), job->hashes.end());
+            job.reset();
+        }
+
+        return ! threadShouldExit();
+    }
+
+    void handleAsyncUpdate() override
+    {
+        {
+            const juce::ScopedLock sl (pendingLock);
+            result = std::move (pendingResult);
+        }
+
+        if (result != nullptr && onFinished != nullptr)
+            onFinished();
+    }
+
+    //==============================================================================
+    static constexpr size_t blockSize = 4 * 1024 * 1024;
+    static constexpr int maximumHashThreads = 16;
+    static constexpr int stopTimeoutMs = 10000;
+
+    juce::File files[2];
+    juce::int64 startTicks = 0;
+    std::unique_ptr<Result> result;            // only used on the message thread
+
+    juce::CriticalSection pendingLock;
+    std::unique_ptr<Result> pendingResult;
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TextFileDiff)
+};
@@ -0,0 +1,795 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE tutorials.
+   Copyright (c) 2020 - Raw Material Software Limited
+
+   The code included in this file is provided under the terms of the ISC license
+   http://www.isc.org/downloads/software-support-policy/isc-license. Permission
+   To use, copy, modify, and/or distribute this software for any purpose with or
+   without fee is hereby granted provided that the above copyright notice and
+   this permission notice appear in all copies.
+
+   THE SOFTWARE IS PROVIDED "AS IS" WITHOUT ANY WARRANTY, AND ALL WARRANTIES,
+   WHETHER EXPRESSED OR IMPLIED, INCLUDING MERCHANTABILITY AND FITNESS FOR
+   PURPOSE, ARE DISCLAIMED.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "TextLineIndex.h"
+#include "TextStyleRuns.h"
+#include "FileChangeWatcher.h"
+#include "TextLineIndexCache.h"
+#include "CompressedTextSource.h"
+#include "PagedTextSource.h"
+#include "LoadTimings.h"
+
+//==============================================================================
+/**
+    Maps a text file and indexes its lines on a background thread.
+
+    The file is scanned in chunks, and after each chunk the new line breaks are
+    handed over to the message thread, where they're added to the index and
+    onProgress is called. The first chunk is kept small so that something can be
+    shown straight away.
+
+    If word colouring is turned on, every space-separated word is also given a
+    random colour, like FileReadingTutorial_04 does, but the colours are recorded
+    as TextStyleRuns rather than being pushed into a TextEditor one by one.
+
+    Large files are split into chunks that are scanned and coloured on a thread
+    pool using all the available cores. The results are stitched back together in
+    file order and are identical to a single-threaded scan.
+
+    The line breaks of larger files are saved to a TextLineIndexCache as they're
+    found, and if a valid cache exists when a file is opened, it's mapped straight
+    into the index instead of scanning the file again.
+
+    In follow mode the thread keeps watching the file once it has been read. When
+    more text is appended, the file is mapped again and only the new bytes are
+    scanned, so a growing log never gets re-read from the start. If the file
+    shrinks (e.g. a log was rotated) it's loaded again from scratch.
+
+    A gzip (or zstd) file is decompressed as it's scanned rather than mapped, and
+    afterwards its text is decoded again on demand by a CompressedTextSource, so
+    only the parts being looked at are held in memory. Compressed files are
+    scanned on the loader thread alone, and aren't cached or followed.
+
+    With a memory budget set, the file is read a page at a time by a
+    PagedTextSource instead of being mapped, keeping the pages in the
+    process-wide SharedPageCache, and the line index only keeps as many breaks
+    as its share of the budget allows, finding the lines in between by scanning
+    from the nearest known one. Word colouring, caching and follow
+    mode are turned off, as they'd need memory in proportion to the file.
+
+    Each stage of a load is timed by a LoadTimings. For a mapped file, a byte of
+    every page is read before it's scanned, so that waiting for the disk shows up
+    as reading rather than as tokenizing.
+
+    Loading another file (or calling cancel()) stops the previous scan before its
+    data source is released, so the thread never sees a file that has gone away.
+    The index and the text should only be used on the message thread.
+*/
+class TextFileLoader  : private juce::Thread,
+                        private juce::AsyncUpdater
+{
+public:
+    TextFileLoader()
+        : juce::Thread ("TextFileLoader")
+    {
+    }
+
+    ~TextFileLoader() override
+    {
+        cancel();
+    }
+
+    /** Turns random per-word colouring on or off for subsequent loads. */
+    void setWordColouring (bool shouldColourWords) noexcept
+    {
+        jassert (! isThreadRunning());
+        colourWords = shouldColourWords;
+    }
+
+    bool isWordColouring() const noexcept                 { return colourWords; }
+
+    /** Turns follow mode on or off. This can be changed while a file is loaded. */
+    void setFollowing (bool shouldFollow)
+    {
+        following = shouldFollow;
+        notify();
+    }
+
+    bool isFollowing() const noexcept                     { return following; }
+
+    /** Sets a rough limit on the memory used for subsequent loads, or 0 for none.
+        A quarter of it is used for the line index. The pages of text are held in
+        the SharedPageCache, whose budget covers every open file.
+    */
+    void setMemoryBudget (size_t numBytes) noexcept
+    {
+        jassert (! isThreadRunning());
+        memoryBudget = numBytes;
+    }
+
+    size_t getMemoryBudget() const noexcept               { return memoryBudget; }
+
+    /** Starts loading a file, cancelling any load already in progress. */
+    bool load (const juce::File& file)
+    {
+        cancel();
+
+        if (! file.existsAsFile())
+            return false;  // file doesn't exist
+
+        timings.reset (file);
+        LoadTimings::ScopedTimer timer (timings, LoadTimings::Stage::open, file.getSize());
+
+        auto format = CompressedTextSource::detectFormat (file);
+
+        lineIndex.setMaximumNumBreaks (memoryBudget / 4 / sizeof (juce::int64));
+        scanWords = colourWords && memoryBudget == 0;
+
+        if (CompressedTextSource::isSupported (format))
+        {
+            compressedSource = std::make_shared<CompressedTextSource> (file, format);
+            source = compressedSource;
+        }
+        else if (memoryBudget > 0)
+        {
+            auto pages = std::make_shared<PagedTextSource> (file);
+
+            if (! pages->openedOk())
+                return false;  // failed to open (or the file is empty)
+
+            source = pagedSource = std::move (pages);
+        }
+        else
+        {
+            auto mapping = std::make_shared<MappedTextSource> (file);
+
+            if (! mapping->openedOk())
+                return false;  // failed to map (or the file is empty)
+
+            source = workerMappedFile = std::move (mapping);
+        }
+
+        loadedFile = file;
+
+        startThread();
+        return true;
+    }
+
+    /** Stops any load in progress and releases the file. */
+    void cancel()
+    {
+        stopThread (stopTimeoutMs);
+        cancelPendingUpdate();
+
+        {
+            const juce::ScopedLock sl (pendingLock);
+            pendingLineBreaks.clear();
+            pendingStyleRuns.clear();
+            pendingSource.reset();
+            pendingCachedBreaks = {};
+            pendingBytesScanned = 0;
+            pendingScanFinished = false;
+            pendingTruncation = false;
+        }
+
+        lineIndex.clear();
+        styleRuns.clear();
+        source.reset();
+        workerMappedFile.reset();
+        compressedSource.reset();
+        pagedSource.reset();
+        lastLineFound = { 0, 0 };
+        initialScanFinished = false;
+        loadedFile = juce::File();
+    }
+
+    /** Returns true once the whole file has been indexed. */
+    bool isLoaded() const noexcept                        { return source != nullptr && initialScanFinished; }
+
+    /** Returns the text in a range of the indexed bytes. The pointer stays valid
+        until getBytes() is called again.
+    */
+    const char* getBytes (juce::Range<juce::int64> range) const
+    {
+        jassert (source != nullptr && range.getEnd() <= (juce::int64) getSize());
+        return source->getBytes (range);
+    }
+
+    /** Returns the number of bytes that have been indexed so far. */
+    size_t getSize() const noexcept                       { return lineIndex.getTotalBytes(); }
+    const TextLineIndex& getLineIndex() const noexcept    { return lineIndex; }
+    const TextStyleRuns& getStyleRuns() const noexcept    { return styleRuns; }
+
+    /** Returns the timings of the current (or last) load. The view adds its own
+        stages to these.
+    */
+    LoadTimings& getTimings() noexcept                    { return timings; }
+    const LoadTimings& getTimings() const noexcept        { return timings; }
+
+    juce::int64 getNumLines() const noexcept              { return lineIndex.getNumLines(); }
+
+    /** Returns the byte range of a line, including its line-ending characters.
+        Unlike TextLineIndex::getLineRange(), this works when the index is sampled.
+    */
+    juce::Range<juce::int64> getLineRange (juce::int64 line) const
+    {
+        if (! lineIndex.isSampled())
+            return lineIndex.getLineRange (line);
+
+        auto start = findLineStart (line);
+        return { start, findNextLineStart (start) };
+    }
+
+    /** Returns the index of the line that contains a byte offset. */
+    juce::int64 getLineContaining (juce::int64 offset) const
+    {
+        if (! lineIndex.isSampled())
+            return lineIndex.getLineContaining (offset);
+
+        auto known = lineIndex.getNearestLineStartBefore (offset);
+        return juce::jmin (known.line + countLineBreaks (known.offset, offset), getNumLines() - 1);
+    }
+
+    /** Hints that the text after a position (or before it, if scrolling
+        backwards) will be wanted soon.
+    */
+    void prefetch (juce::int64 position, bool forwards)
+    {
+        if (pagedSource != nullptr)
+            pagedSource->prefetch (position, forwards);
+    }
+
+    /** Called on the message thread each time more of the file has been indexed. */
+    std::function<void()> onProgress;
+
+private:
+    //==============================================================================
+    // With a sampled index, a line is found by counting line breaks forwards from
+    // the nearest line whose start is known, or from the last line found if
+    // that's closer, which it is when consecutive lines are being painted.
+    juce::int64 findLineStart (juce::int64 line) const
+    {
+        auto from = lineIndex.getNearestLineStart (line);
+
+        if (lastLineFound.line <= line && lastLineFound.line > from.line)
+            from = lastLineFound;
+
+        auto offset = from.offset;
+
+        for (auto i = from.line; i < line; ++i)
+            offset = findNextLineStart (offset);
+
+        lastLineFound = { line, offset };
+        return offset;
+    }
+
+    juce::int64 findNextLineStart (juce::int64 offset) const
+    {
+        auto end = (juce::int64) getSize();
+
+        while (offset < end)
+        {
+            auto blockEnd = juce::jmin (end, (offset / lineSearchBlockSize + 1) * lineSearchBlockSize);
+            auto* data = getBytes ({ offset, blockEnd });
+
+            if (auto* newLine = static_cast<const char*> (std::memchr (data, '\n', (size_t) (blockEnd - offset))))
+                return offset + (newLine - data) + 1;
+
+            offset = blockEnd;
+        }
+
+        return end;
+    }
+
+    juce::int64 countLineBreaks (juce::int64 start, juce::int64 end) const
+    {
+        juce::int64 numBreaks = 0;
+
+        while (start < end)
+        {
+            auto blockEnd = juce::jmin (end, (start / lineSearchBlockSize + 1) * lineSearchBlockSize);
+            auto* data = getBytes ({ start, blockEnd });
+
+            numBreaks += std::count (data, data + (blockEnd - start), '\n');
+            start = blockEnd;
+        }
+
+        return numBreaks;
+    }
+
+    //==============================================================================
+    /**
+        Gives each word a random colour that depends only on where the word is.
+
+        The file is divided into fixed-size cells, and the words whose separating
+        space falls in a cell take their colours in order from a Random seeded with
+        that cell's number. So the cells can be coloured in any order, on any
+        number of threads, and the result is always the same as a serial pass.
+        The very first word has no separator, so it gets a seed of its own.
+    */
+    struct WordColourer
+    {
+        TextStyleRuns::Run makeWordRun (juce::int64 wordStart)
+        {
+            auto cell = wordStart > 0 ? (wordStart - 1) / (juce::int64) cellSize : -1;
+
+            if (cell != currentCell)
+            {
+                currentCell = cell;
+                random.setSeed (randomSeed + cell);
+            }
+
+            return { wordStart, getRandomColour (0.75f).getARGB(), juce::Font::plain };
+        }
+
+        juce::Colour getRandomColour (float minBrightness)
+        {
+            juce::Colour colour ((juce::uint8) random.nextInt (256),
+                                 (juce::uint8) random.nextInt (256),
+                                 (juce::uint8) random.nextInt (256));
+
+            return colour.getBrightness() >= minBrightness ? colour
+                                                           : colour.withBrightness (minBrightness);
+        }
+
+        static constexpr size_t cellSize = 4 * 1024 * 1024;
+
+        juce::Random random;
+        juce::int64 currentCell = -1;
+    };
+
+    struct ScannedChunk
+    {
+        std::vector<juce::int64> lineBreaks, wordBreaks;
+        std::vector<TextStyleRuns::Run> wordRuns;
+    };
+
+    //==============================================================================
+    void run() override
+    {
+        WordColourer colourer;
+        size_t numBytesScanned = 0;
+
+        if (scanWords)
+            publish ({}, { colourer.makeWordRun (0) }, 0);
+
+        if (compressedSource != nullptr)
+        {
+            scanCompressed (colourer);
+            return;
+        }
+
+        if (pagedSource != nullptr)
+        {
+            scanWithoutMapping (colourer);
+            finishInitialScan();
+            return;
+        }
+
+        // Word colours aren't cached, so a file being coloured always gets scanned.
+        if (scanWords || ! loadCachedIndex (numBytesScanned))
+        {
+            auto size = workerMappedFile->getSize();
+            std::unique_ptr<TextLineIndexCache::Writer> cacheWriter;
+
+            if (size >= minimumCachedFileSize)
+                cacheWriter.reset (new TextLineIndexCache::Writer (loadedFile, size));
+
+            if (size >= minimumParallelFileSize && juce::SystemStats::getNumCpus() > 1)
+                scanInParallel (numBytesScanned, colourer, cacheWriter.get());
+            else
+                scan (numBytesScanned, colourer, cacheWriter.get());
+
+            if (cacheWriter != nullptr && ! threadShouldExit())
+                cacheWriter->finish();
+        }
+
+        finishInitialScan();
+
+        std::unique_ptr<FileChangeWatcher> watcher;
+
+        while (! threadShouldExit())
+        {
+            if (! following)
+            {
+                wait (-1);  // woken up by setFollowing() or stopThread()
+                continue;
+            }
+
+            if (watcher == nullptr)
+                watcher.reset (new FileChangeWatcher (loadedFile));
+
+            // Even with notifications the size is re-checked after the timeout,
+            // in case an event was missed.
+            if (watcher->isWatching())
+                watcher->waitForChange (followIntervalMs);
+            else
+                wait (followIntervalMs);
+
+            auto newSize = loadedFile.getSize();
+
+            if (newSize < (juce::int64) numBytesScanned)
+            {
+                const juce::ScopedLock sl (pendingLock);
+                pendingTruncation = true;
+                triggerAsyncUpdate();
+                return;
+            }
+
+            if (newSize == (juce::int64) numBytesScanned)
+                continue;
+
+            std::shared_ptr<MappedTextSource> mapping;
+
+            {
+                LoadTimings::ScopedTimer timer (timings, LoadTimings::Stage::open, newSize);
+                mapping = std::make_shared<MappedTextSource> (loadedFile);
+            }
+
+            if (! mapping->openedOk() || mapping->getSize() <= numBytesScanned)
+                continue;
+
+            workerMappedFile = std::move (mapping);
+            scan (numBytesScanned, colourer, nullptr);
+        }
+    }
+
+    bool loadCachedIndex (size_t& numBytesScanned)
+    {
+        auto size = workerMappedFile->getSize();
+        LoadTimings::ScopedTimer timer (timings, LoadTimings::Stage::open, (juce::int64) size);
+        auto cached = TextLineIndexCache::load (loadedFile, workerMappedFile->getData(), size);
+
+        if (cached.mapping == nullptr)
+            return false;
+
+        {
+            const juce::ScopedLock sl (pendingLock);
+            pendingCachedBreaks = std::move (cached);
+            pendingSource = workerMappedFile;
+            pendingBytesScanned = size;
+        }
+
+        triggerAsyncUpdate();
+        numBytesScanned = size;
+        return true;
+    }
+
+    // Scans numBytes of text that begin at the given offset into the file.
+    void scanChunk (const char* data, size_t start, size_t numBytes, WordColourer& colourer, ScannedChunk& chunk)
+    {
+        chunk.lineBreaks.clear();
+        chunk.wordBreaks.clear();
+        chunk.wordRuns.clear();
+
+        {
+            LoadTimings::ScopedTimer timer (timings, LoadTimings::Stage::tokenize, (juce::int64) numBytes);
+            TextScanner::findBreaks (data, numBytes, (juce::int64) start,
+                                     chunk.lineBreaks, scanWords ? &chunk.wordBreaks : nullptr);
+        }
+
+        if (! scanWords)
+            return;
+
+        LoadTimings::ScopedTimer timer (timings, LoadTimings::Stage::style, (juce::int64) numBytes);
+
+        // A break at the very end is kept: it's where the next appended word starts.
+        for (auto wordStart : chunk.wordBreaks)
+            chunk.wordRuns.push_back (colourer.makeWordRun (wordStart));
+    }
+
+    // Reads one byte from each page of the mapping, so that the pages are faulted
+    // in (and timed) before they're scanned.
+    void readMappedPages (const char* data, size_t numBytes)
+    {
+        LoadTimings::ScopedTimer timer (timings, LoadTimings::Stage::read, (juce::int64) numBytes);
+        auto* bytes = static_cast<const volatile char*> (data);
+        char checksum = 0;
+
+        for (size_t i = 0; i < numBytes; i += pageSize)
+            checksum ^= bytes[i];
+
+        juce::ignoreUnused (checksum);
+    }
+
+    // Scans whatever the worker's current mapping holds beyond numBytesScanned.
+    void scan (size_t& numBytesScanned, WordColourer& colourer, TextLineIndexCache::Writer* cacheWriter)
+    {
+        auto size = workerMappedFile->getSize();
+        auto chunkSize = initialChunkSize;
+        ScannedChunk chunk;
+
+        while (numBytesScanned < size && ! threadShouldExit())
+        {
+            auto numBytes = juce::jmin (chunkSize, size - numBytesScanned);
+            auto* data = workerMappedFile->getData() + numBytesScanned;
+
+            readMappedPages (data, numBytes);
+            scanChunk (data, numBytesScanned, numBytes, colourer, chunk);
+            numBytesScanned += numBytes;
+
+            if (cacheWriter != nullptr)
+                cacheWriter->addBreaks (chunk.lineBreaks);
+
+            publish (chunk.lineBreaks, chunk.wordRuns, numBytesScanned);
+            chunkSize = juce::jmin (chunkSize * 2, maximumChunkSize);
+        }
+    }
+
+    // Scans the whole mapping one colour cell per job on a thread pool. The jobs
+    // finish in any order, but their results are published strictly in file order,
+    // keeping a few jobs per core in flight. Afterwards the colourer is left as the
+    // last job's was, part-way through the last cell, so that words appended to
+    // that cell get the same colours as they would after a serial scan.
+    void scanInParallel (size_t& numBytesScanned, WordColourer& colourer, TextLineIndexCache::Writer* cacheWriter)
+    {
+        struct Job
+        {
+            ScannedChunk chunk;
+            WordColourer colourer;
+            size_t end = 0;
+            juce::WaitableEvent finished;
+        };
+
+        auto size = workerMappedFile->getSize();
+        auto numThreads = juce::jmin (juce::SystemStats::getNumCpus(), maximumScanThreads);
+        juce::ThreadPool pool (numThreads);
+        std::deque<std::unique_ptr<Job>> jobsInFlight;
+        size_t nextStart = numBytesScanned;
+
+        while (numBytesScanned < size && ! threadShouldExit())
+        {
+            while (nextStart < size && (int) jobsInFlight.size() < numThreads * 2)
+            {
+                auto cellEnd = (nextStart / WordColourer::cellSize + 1) * WordColourer::cellSize;
+
+                jobsInFlight.emplace_back (new Job());
+                auto* job = jobsInFlight.back().get();
+                job->end = juce::jmin (cellEnd, size);
+
+                pool.addJob ([this, job, start = nextStart]
+                {
+                    if (! threadShouldExit())
+                    {
+                        auto* data = workerMappedFile->getData() + start;
+                        readMappedPages (data, job->end - start);
+                        scanChunk (data, start, job->end - start, job->colourer, job->chunk);
+                    }
+
+                    job->finished.signal();
+                });
+
+                nextStart = job->end;
+            }
+
+            auto job = std::move (jobsInFlight.front());
+            jobsInFlight.pop_front();
+            job->finished.wait();
+
+            if (threadShouldExit())
+                break;
+
+            numBytesScanned = job->end;
+            colourer = job->colourer;
+
+            if (cacheWriter != nullptr)
+                cacheWriter->addBreaks (job->chunk.lineBreaks);
+
+            publish (job->chunk.lineBreaks, job->chunk.wordRuns, numBytesScanned);
+        }
+
+        for (auto& job : jobsInFlight)
+            job->finished.wait();
+    }
+
+    // Decompresses the file block by block, scanning each block as it arrives and
+    // publishing the results every chunk's worth of text.
+    void scanCompressed (WordColourer& colourer)
+    {
+        ScannedChunk chunk, accumulated;
+        size_t numBytesScanned = 0, numBytesPublished = 0;
+        auto chunkSize = initialChunkSize;
+
+        auto publishAccumulated = [&]
+        {
+            publish (accumulated.lineBreaks, accumulated.wordRuns, numBytesScanned);
+            accumulated.lineBreaks.clear();
+            accumulated.wordRuns.clear();
+            numBytesPublished = numBytesScanned;
+            chunkSize = juce::jmin (chunkSize * 2, maximumChunkSize);
+        };
+
+        // The time between blocks is the time spent reading and decompressing.
+        auto readStartTicks = juce::Time::getHighResolutionTicks();
+
+        compressedSource->decompressAll ([&] (const char* block, size_t numBytes)
+                                         {
+                                             timings.add (LoadTimings::Stage::read, juce::Time::getHighResolutionTicks() - readStartTicks, (juce::int64) numBytes);
+
+                                             scanChunk (block, numBytesScanned, numBytes, colourer, chunk);
+                                             numBytesScanned += numBytes;
+
+                                             accumulated.lineBreaks.insert (accumulated.lineBreaks.end(), chunk.lineBreaks.begin(), chunk.lineBreaks.end());
+                                             accumulated.wordRuns.insert (accumulated.wordRuns.end(), chunk.wordRuns.begin(), chunk.wordRuns.end());
+
+                                             if (numBytesScanned - numBytesPublished >= chunkSize)
+                                                 publishAccumulated();
+
+                                             readStartTicks = juce::Time::getHighResolutionTicks();
+                                         },
+                                         [this] { return threadShouldExit(); });
+
+        if (threadShouldExit())
+            return;
+
+        publishAccumulated();
+        finishInitialScan();
+    }
+
+    // Reads the file through a small buffer, so that scanning it doesn't make any
+    // of it resident.
+    void scanWithoutMapping (WordColourer& colourer)
+    {
+        juce::FileInputStream input (loadedFile);
+        juce::HeapBlock<char> buffer (readBufferSize);
+        auto size = pagedSource->getSize();
+        size_t numBytesScanned = 0;
+        ScannedChunk chunk;
+
+        while (numBytesScanned < size && input.openedOk() && ! threadShouldExit())
+        {
+            int numRead;
+
+            {
+                LoadTimings::ScopedTimer timer (timings, LoadTimings::Stage::read);
+                numRead = input.read (buffer, (int) juce::jmin (readBufferSize, size - numBytesScanned));
+                timer.numBytes = juce::jmax (0, numRead);
+            }
+
+            if (numRead <= 0)
+                break;
+
+            scanChunk (buffer, numBytesScanned, (size_t) numRead, colourer, chunk);
+            numBytesScanned += (size_t) numRead;
+            publish (chunk.lineBreaks, chunk.wordRuns, numBytesScanned);
+        }
+    }
+
+    void finishInitialScan()
+    {
+        {
+            const juce::ScopedLock sl (pendingLock);
+            pendingScanFinished = true;
+        }
+
+        triggerAsyncUpdate();
+    }
+
+    void publish (const std::vector<juce::int64>& lineBreaks,
+                  const std::vector<TextStyleRuns::Run>& wordRuns,
+                  size_t numBytesScanned)
+    {
+        // With a memory budget the thread mustn't get too far ahead of the message
+        // thread, or the breaks waiting to be indexed would pile up.
+        while (memoryBudget > 0 && ! threadShouldExit())
+        {
+            {
+                const juce::ScopedLock sl (pendingLock);
+
+                if (pendingLineBreaks.size() * sizeof (juce::int64) < memoryBudget / 16)
+                    break;
+            }
+
+            wait (10);  // woken up by handleAsyncUpdate()
+        }
+
+        {
+            const juce::ScopedLock sl (pendingLock);
+            pendingLineBreaks.insert (pendingLineBreaks.end(), lineBreaks.begin(), lineBreaks.end());
+            pendingStyleRuns.insert (pendingStyleRuns.end(), wordRuns.begin(), wordRuns.end());
+            if (workerMappedFile != nullptr)
+                pendingSource = workerMappedFile;
+
+            pendingBytesScanned = numBytesScanned;
+        }
+
+        triggerAsyncUpdate();
+    }
+
+    void handleAsyncUpdate() override
+    {
+        std::vector<juce::int64> lineBreaks;
+        std::vector<TextStyleRuns::Run> newStyleRuns;
+        std::shared_ptr<TextDataSource> newSource;
+        TextLineIndexCache::MappedBreaks cachedBreaks;
+        size_t bytesScanned;
+        bool scanFinished, truncated;
+
+        {
+            const juce::ScopedLock sl (pendingLock);
+            lineBreaks.swap (pendingLineBreaks);
+            newStyleRuns.swap (pendingStyleRuns);
+            newSource.swap (pendingSource);
+            std::swap (cachedBreaks, pendingCachedBreaks);
+            bytesScanned = pendingBytesScanned;
+            scanFinished = pendingScanFinished;
+            truncated = pendingTruncation;
+        }
+
+        notify();
+
+        if (truncated)
+        {
+            load (juce::File (loadedFile));
+        }
+        else
+        {
+            LoadTimings::ScopedTimer timer (timings, LoadTimings::Stage::layout,
+                                            juce::jmax ((juce::int64) 0, (juce::int64) bytesScanned - (juce::int64) lineIndex.getTotalBytes()));
+
+            // The new mapping covers at least as many bytes as the new breaks refer to.
+            if (newSource != nullptr)
+                source = std::move (newSource);
+
+            if (cachedBreaks.mapping != nullptr)
+                lineIndex.setSharedBreaks (cachedBreaks.mapping, cachedBreaks.breaks,
+                                           cachedBreaks.numBreaks, cachedBreaks.textSize);
+
+            lineIndex.appendBreaks (lineBreaks, bytesScanned);
+            styleRuns.appendRuns (newStyleRuns);
+            initialScanFinished = scanFinished;
+
+            if (initialScanFinished)
+                timings.markFinished();
+        }
+
+        if (onProgress != nullptr)
+            onProgress();
+    }
+
+    //==============================================================================
+    static constexpr size_t initialChunkSize = 64 * 1024;
+    static constexpr size_t maximumChunkSize = 16 * 1024 * 1024;
+    static constexpr int stopTimeoutMs = 10000;
+    static constexpr int followIntervalMs = 50;
+    static constexpr size_t minimumCachedFileSize = 1024 * 1024;
+    static constexpr size_t minimumParallelFileSize = 2 * WordColourer::cellSize;
+    static constexpr int maximumScanThreads = 16;
+    static constexpr juce::int64 randomSeed = 0x5eed;
+    static constexpr size_t readBufferSize = 1024 * 1024;
+    static constexpr juce::int64 lineSearchBlockSize = 64 * 1024;
+    static constexpr size_t pageSize = 4096;
+
+    juce::File loadedFile;
+    std::shared_ptr<TextDataSource> source;                    // only used on the message thread
+    std::shared_ptr<MappedTextSource> workerMappedFile;        // only used on the loader thread
+    std::shared_ptr<CompressedTextSource> compressedSource;    // decompressed by the loader thread, read by the message thread
+    std::shared_ptr<PagedTextSource> pagedSource;              // read by the message thread, only its size by the loader thread
+    TextLineIndex lineIndex;
+    TextStyleRuns styleRuns;
+    mutable TextLineIndex::LineStart lastLineFound { 0, 0 };
+    bool initialScanFinished = false;
+    bool colourWords = false, scanWords = false;
+    size_t memoryBudget = 0;
+    std::atomic<bool> following { false };
+    LoadTimings timings;
+
+    juce::CriticalSection pendingLock;
+    std::vector<juce::int64> pendingLineBreaks;
+    std::vector<TextStyleRuns::Run> pendingStyleRuns;
+    std::shared_ptr<TextDataSource> pendingSource;
+    TextLineIndexCache::MappedBreaks pendingCachedBreaks;
+    size_t pendingBytesScanned = 0;
+    bool pendingScanFinished = false, pendingTruncation = false;
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TextFileLoader)
+};
@@ -0,0 +1,338 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE tutorials.
+   Copyright (c) 2020 - Raw Material Software Limited
+
+   The code included in this file is provided under the terms of the ISC license
+   http://www.isc.org/downloads/software-support-policy/isc-license. Permission
+   To use, copy, modify, and/or distribute this software for any purpose with or
+   without fee is hereby granted provided that the above copyright notice and
+   this permission notice appear in all copies.
+
+   THE SOFTWARE IS PROVIDED "AS IS" WITHOUT ANY WARRANTY, AND ALL WARRANTIES,
+   WHETHER EXPRESSED OR IMPLIED, INCLUDING MERCHANTABILITY AND FITNESS FOR
+   PURPOSE, ARE DISCLAIMED.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "TextSearch.h"
+#include "CompressedTextSource.h"
+
+//==============================================================================
+/**
+    Searches a text file for a string on a background thread.
+
+    The file is searched a chunk at a time with TextSearch, and the offsets of the
+    matches are handed over to the message thread after each chunk, where they're
+    added to getMatches() and onProgress is called. So hits can be shown while a
+    large file is still being searched.
+
+    The matches are kept in file order, so moving to the next or previous one is
+    just a binary search and never needs the file to be searched again. When a
+    file grows, searchMore() only looks at the new text.
+
+    The thread opens the file itself (decompressing it if it's compressed), so
+    it never touches any data being used by the message thread.
+*/
+class TextFileSearch  : private juce::Thread,
+                        private juce::AsyncUpdater
+{
+public:
+    TextFileSearch()
+        : juce::Thread ("TextFileSearch")
+    {
+    }
+
+    ~TextFileSearch() override
+    {
+        cancel();
+    }
+
+    /** With a memory budget, files are read through a buffer that's a small part
+        of it rather than being mapped. This takes effect from the next search.
+    */
+    void setMemoryBudget (size_t numBytes) noexcept      { memoryBudget = numBytes; }
+
+    /** Starts searching the first numBytes of a file, cancelling any search
+        already in progress.
+    */
+    void start (const juce::File& file, const juce::String& textToFind, size_t numBytes)
+    {
+        cancel();
+
+        if (textToFind.isEmpty() || ! file.existsAsFile())
+            return;
+
+        searchFile = file;
+        searchText = textToFind;
+        pattern = juce::MemoryBlock (textToFind.toRawUTF8(), textToFind.getNumBytesAsUTF8());
+        searchStart = 0;
+        searchEnd = requestedEnd = numBytes;
+        threadIsIdle = false;
+
+        startThread();
+    }
+
+    /** Extends the search to cover text that has since been appended to the file.
+        If the search is still running, it carries on up to the new end once it
+        has finished the text it was given.
+    */
+    void searchMore (size_t newNumBytes)
+    {
+        if (searchText.isEmpty())
+            return;
+
+        {
+            const juce::ScopedLock sl (pendingLock);
+
+            if (newNumBytes <= requestedEnd)
+                return;
+
+            requestedEnd = newNumBytes;
+
+            if (! threadIsIdle)
+                return;
+
+            threadIsIdle = false;
+        }
+
+        // The thread has already finished its last range, so this won't block for long.
+        waitForThreadToExit (stopTimeoutMs);
+
+        searchStart = searchEnd;
+        searchEnd = newNumBytes;
+        startThread();
+    }
+
+    /** Stops any search in progress and forgets the matches. */
+    void cancel()
+    {
+        stopThread (stopTimeoutMs);
+        cancelPendingUpdate();
+
+        {
+            const juce::ScopedLock sl (pendingLock);
+            pendingMatches.clear();
+            pendingBytesSearched = 0;
+            requestedEnd = 0;
+            threadIsIdle = true;
+        }
+
+        matches.clear();
+        numBytesSearched = searchStart = searchEnd = 0;
+        searchText = {};
+        searchFile = juce::File();
+    }
+
+    bool isSearching() const                                    { return isThreadRunning() || numBytesSearched < requestedEnd; }
+    const juce::String& getSearchText() const noexcept          { return searchText; }
+
+    /** Returns the length of a match in bytes. */
+    size_t getMatchLength() const noexcept                      { return pattern.getSize(); }
+
+    /** Returns the offset of each match found so far, in order. */
+    const std::vector<juce::int64>& getMatches() const noexcept { return matches; }
+
+    /** Returns the index of the first match starting at or after an offset, or
+        the number of matches if there isn't one.
+    */
+    size_t findFirstMatchFrom (juce::int64 offset) const
+    {
+        return (size_t) (std::lower_bound (matches.begin(), matches.end(), offset) - matches.begin());
+    }
+
+    /** Called on the message thread each time more of the file has been searched. */
+    std::function<void()> onProgress;
+
+private:
+    //==============================================================================
+    void run() override
+    {
+        std::vector<juce::int64> found;
+
+        while (! threadShouldExit())
+        {
+            searchRange (found);
+
+            if (threadShouldExit())
+                return;
+
+            publish (found, searchEnd);
+
+            // Carries on if searchMore() has asked for more while this range was
+            // being searched, otherwise it would be left waiting for a thread
+            // that's no longer going to look at it.
+            const juce::ScopedLock sl (pendingLock);
+
+            if (requestedEnd <= searchEnd)
+            {
+                threadIsIdle = true;
+                return;
+            }
+
+            searchStart = searchEnd;
+            searchEnd = requestedEnd;
+        }
+    }
+
+    // Searches from searchStart to searchEnd, publishing the matches as it goes.
+    void searchRange (std::vector<juce::int64>& found)
+    {
+        auto* patternData = static_cast<const char*> (pattern.getData());
+        auto patternLength = pattern.getSize();
+
+        // Backs up far enough to catch a match that straddles the previous end.
+        auto start = searchStart - juce::jmin (searchStart, patternLength - 1);
+        auto format = CompressedTextSource::detectFormat (searchFile);
+
+        if (CompressedTextSource::isSupported (format))
+        {
+            // The text is searched as it's decompressed, carrying over the end of
+            // each block in case a match continues into the next one. The text
+            // before start was covered by an earlier range, so matches in it are
+            // dropped rather than being added twice.
+            CompressedTextSource source (searchFile, format);
+            juce::MemoryBlock window;
+            size_t windowStart = 0, lastPublished = 0;
+
+            source.decompressAll ([&] (const char* block, size_t numBytes)
+                                  {
+                                      if (windowStart + window.getSize() >= searchEnd)
+                                          return;
+
+                                      numBytes = juce::jmin (numBytes, searchEnd - (windowStart + window.getSize()));
+                                      window.append (block, numBytes);
+
+                                      if (windowStart + window.getSize() > start)
+                                      {
+                                          auto numBefore = found.size();
+
+                                          TextSearch::findAll (static_cast<const char*> (window.getData()), window.getSize(),
+                                                               patternData, patternLength, (juce::int64) windowStart, found);
+
+                                          found.erase (std::remove_if (found.begin() + (std::ptrdiff_t) numBefore, found.end(),
+                                                                       [start] (juce::int64 offset) { return offset < (juce::int64) start; }),
+                                                       found.end());
+                                      }
+
+                                      auto numToKeep = juce::jmin (window.getSize(), patternLength - 1);
+                                      auto windowEnd = windowStart + window.getSize();
+                                      window.removeSection (0, window.getSize() - numToKeep);
+                                      windowStart = windowEnd - numToKeep;
+
+                                      if (windowEnd - lastPublished >= chunkSize)
+                                      {
+                                          publish (found, windowEnd);
+                                          lastPublished = windowEnd;
+                                      }
+                                  },
+                                  [&] { return threadShouldExit() || windowStart + window.getSize() >= searchEnd; });
+        }
+        else if (memoryBudget > 0)
+        {
+            // Consecutive reads overlap so that a match can straddle two of them.
+            juce::FileInputStream input (searchFile);
+            auto bufferSize = juce::jmax (patternLength * 2, juce::jmin (chunkSize, memoryBudget / 16));
+            juce::HeapBlock<char> buffer (bufferSize);
+
+            for (auto chunkStart = start; chunkStart < searchEnd && input.openedOk() && ! threadShouldExit();)
+            {
+                input.setPosition ((juce::int64) chunkStart);
+                auto numToRead = juce::jmin (bufferSize, searchEnd - chunkStart);
+                auto numRead = input.read (buffer, (int) numToRead);
+
+                if (numRead <= 0)
+                    break;
+
+                auto chunkEnd = chunkStart + (size_t) numRead;
+                TextSearch::findAll (buffer, (size_t) numRead, patternData, patternLength, (juce::int64) chunkStart, found);
+                publish (found, chunkEnd);
+
+                // A short read means the file has shrunk, and carrying on would
+                // read the same tail again forever.
+                if (chunkEnd == searchEnd || (size_t) numRead < numToRead)
+                    break;
+
+                chunkStart = chunkEnd - (patternLength - 1);
+            }
+        }
+        else
+        {
+            MappedTextSource source (searchFile);
+
+            if (source.openedOk())
+            {
+                auto end = juce::jmin (searchEnd, source.getSize());
+
+                for (auto chunkStart = start; chunkStart < end && ! threadShouldExit();)
+                {
+                    auto chunkEnd = juce::jmin (chunkStart + chunkSize, end);
+
+                    TextSearch::findAll (source.getData() + chunkStart, chunkEnd - chunkStart,
+                                         patternData, patternLength, (juce::int64) chunkStart, found);
+
+                    publish (found, chunkEnd);
+
+                    if (chunkEnd == end)
+                        break;
+
+                    chunkStart = chunkEnd - (patternLength - 1);
+                }
+            }
+        }
+    }
+
+    void publish (std::vector<juce::int64>& found, size_t numBytes)
+    {
+        {
+            const juce::ScopedLock sl (pendingLock);
+            pendingMatches.insert (pendingMatches.end(), found.begin(), found.end());
+            pendingBytesSearched = numBytes;
+        }
+
+        found.clear();
+        triggerAsyncUpdate();
+    }
+
+    void handleAsyncUpdate() override
+    {
+        std::vector<juce::int64> newMatches;
+
+        {
+            const juce::ScopedLock sl (pendingLock);
+            newMatches.swap (pendingMatches);
+            numBytesSearched = juce::jmax (numBytesSearched, pendingBytesSearched);
+        }
+
+        matches.insert (matches.end(), newMatches.begin(), newMatches.end());
+
+        if (onProgress != nullptr)
+            onProgress();
+    }
+
+    //==============================================================================
+    static constexpr size_t chunkSize = 16 * 1024 * 1024;
+    static constexpr int stopTimeoutMs = 10000;
+
+    juce::File searchFile;
+    juce::String searchText;
+    juce::MemoryBlock pattern;
+    size_t searchStart = 0, searchEnd = 0;   // set before the thread starts, then moved on by it
+    size_t memoryBudget = 0;
+
+    std::vector<juce::int64> matches;        // only used on the message thread
+    size_t numBytesSearched = 0;
+
+    juce::CriticalSection pendingLock;
+    std::vector<juce::int64> pendingMatches;
+    size_t pendingBytesSearched = 0;
+    size_t requestedEnd = 0;                 // only written on the message thread
+    bool threadIsIdle = true;
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TextFileSearch)
+};
@@ -0,0 +1,213 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE tutorials.
+   Copyright (c) 2020 - Raw Material Software Limited
+
+   The code included in this file is provided under the terms of the ISC license
+   http://www.isc.org/downloads/software-support-policy/isc-license. Permission
+   To use, copy, modify, and/or distribute this software for any purpose with or
+   without fee is hereby granted provided that the above copyright notice and
+   this permission notice appear in all copies.
+
+   THE SOFTWARE IS PROVIDED "AS IS" WITHOUT ANY WARRANTY, AND ALL WARRANTIES,
+   WHETHER EXPRESSED OR IMPLIED, INCLUDING MERCHANTABILITY AND FITNESS FOR
+   PURPOSE, ARE DISCLAIMED.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "TextDataSource.h"
+#include "TextWordStatistics.h"
+#include "CompressedTextSource.h"
+
+//==============================================================================
+/**
+    Works out the word and line statistics of a text file on a background thread.
+
+    The file is mapped and cut into blocks. A few jobs on a thread pool take the
+    blocks in turn, each counting into its own TextWordStatistics::Counter, and
+    those are merged into one set of statistics as they fill up. The words point
+    into the mapped file, which is kept open for as long as the results are.
+
+    The results are handed to the message thread when counting is done, and
+    onFinished is called. Compressed files aren't supported.
+*/
+class TextFileStatistics  : private juce::Thread,
+                            private juce::AsyncUpdater
+{
+public:
+    TextFileStatistics()
+        : juce::Thread ("TextFileStatistics")
+    {
+    }
+
+    ~TextFileStatistics() override
+    {
+        cancel();
+    }
+
+    /** Starts counting a file, cancelling any count in progress. Returns false if
+        the file can't be counted.
+    */
+    bool start (const juce::File& fileToCount)
+    {
+        cancel();
+
+        if (! fileToCount.existsAsFile() || CompressedTextSource::isSupported (CompressedTextSource::detectFormat (fileToCount)))
+            return false;
+
+        file = fileToCount;
+        startTicks = juce::Time::getHighResolutionTicks();
+
+        startThread();
+        return true;
+    }
+
+    /** Stops any count in progress and forgets the results. */
+    void cancel()
+    {
+        stopThread (stopTimeoutMs);
+        cancelPendingUpdate();
+
+        {
+            const juce::ScopedLock sl (pendingLock);
+            pendingResult.reset();
+        }
+
+        result.reset();
+        file = juce::File();
+        numBytesDone = 0;
+        numBytesToDo = 0;
+    }
+
+    bool isCounting() const                 { return isThreadRunning() || (result == nullptr && file != juce::File()); }
+    bool isFinished() const noexcept        { return result != nullptr; }
+
+    const juce::File& getFile() const noexcept      { return file; }
+
+    /** Returns the proportion of the file that has been counted so far. */
+    double getProgress() const noexcept
+    {
+        auto total = numBytesToDo.load();
+        return total > 0 ? (double) numBytesDone.load() / (double) total : 0.0;
+    }
+
+    //==============================================================================
+    /** The rest of these can only be used once counting has finished. */
+    const TextWordStatistics& getStatistics() const noexcept    { return *result->statistics; }
+
+    juce::int64 getNumBytes() const noexcept    { return result->mapping != nullptr ? (juce::int64) result->mapping->getSize() : 0; }
+
+    double getSecondsTaken() const noexcept     { return result->secondsTaken; }
+
+    /** Called on the message thread when counting has finished. */
+    std::function<void()> onFinished;
+
+private:
+    //==============================================================================
+    struct Result
+    {
+        std::shared_ptr<MappedTextSource> mapping;    // null for an empty file
+        std::unique_ptr<TextWordStatistics> statistics { new TextWordStatistics() };
+        double secondsTaken = 0.0;
+    };
+
+    //==============================================================================
+    void run() override
+    {
+        std::unique_ptr<Result> newResult (new Result());
+        auto mapping = std::make_shared<MappedTextSource> (file);
+
+        if (mapping->openedOk())
+        {
+            newResult->mapping = std::move (mapping);
+
+            if (! countWords (*newResult))
+                return;
+        }
+
+        newResult->secondsTaken = juce::Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - startTicks);
+
+        {
+            const juce::ScopedLock sl (pendingLock);
+            pendingResult = std::move (newResult);
+        }
+
+        triggerAsyncUpdate();
+    }
+
+    bool countWords (Result& newResult)
+    {
+        auto* data = newResult.mapping->getData();
+        auto size = newResult.mapping->getSize();
+        auto numBlocks = (size + blockSize - 1) / blockSize;
+        auto numJobs = (int) juce::jmin ((size_t) juce::jmin (juce::SystemStats::getNumCpus(), maximumNumThreads), numBlocks);
+
+        juce::CriticalSection statisticsLock;
+        std::atomic<size_t> nextBlock { 0 };
+        juce::OwnedArray<juce::WaitableEvent> jobsFinished;
+        numBytesToDo = (juce::int64) size;
+
+        {
+            juce::ThreadPool pool (numJobs);
+
+            for (int i = 0; i < numJobs; ++i)
+            {
+                auto* finished = jobsFinished.add (new juce::WaitableEvent());
+
+                pool.addJob ([this, &newResult, &statisticsLock, &nextBlock, finished, data, size, numBlocks]
+                {
+                    {
+                        TextWordStatistics::Counter counter (*newResult.statistics, statisticsLock);
+
+                        for (auto block = nextBlock++; block < numBlocks && ! threadShouldExit(); block = nextBlock++)
+                        {
+                            auto start = block * blockSize;
+                            auto end = juce::jmin (start + blockSize, size);
+
+                            counter.addBlock (data, size, start, end);
+                            numBytesDone += (juce::int64) (end - start);
+                        }
+                    }
+
+                    finished->signal();
+                });
+            }
+
+            for (auto* finished : jobsFinished)
+                finished->wait();
+        }
+
+        return ! threadShouldExit();
+    }
+
+    void handleAsyncUpdate() override
+    {
+        {
+            const juce::ScopedLock sl (pendingLock);
+            result = std::move (pendingResult);
+        }
+
+        if (result != nullptr && onFinished != nullptr)
+            onFinished();
+    }
+
+    //==============================================================================
+    static constexpr size_t blockSize = 4 * 1024 * 1024;
+    static constexpr int maximumNumThreads = 16;
+    static constexpr int stopTimeoutMs = 10000;
+
+    juce::File file;
+    juce::int64 startTicks = 0;
+    std::atomic<juce::int64> numBytesDone { 0 }, numBytesToDo { 0 };
+    std::unique_ptr<Result> result;            // only used on the message thread
+
+    juce::CriticalSection pendingLock;
+    std::unique_ptr<Result> pendingResult;
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TextFileStatistics)
+};
@@ -0,0 +1,514 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE tutorials.
+   Copyright (c) 2020 - Raw Material Software Limited
+
+   The code included in this file is provided under the terms of the ISC license
+   http://www.isc.org/downloads/software-support-policy/isc-license. Permission
+   To use, copy, modify, and/or distribute this software for any purpose with or
+   without fee is hereby granted provided that the above copyright notice and
+   this permission notice appear in all copies.
+
+   THE SOFTWARE IS PROVIDED "AS IS" WITHOUT ANY WARRANTY, AND ALL WARRANTIES,
+   WHETHER EXPRESSED OR IMPLIED, INCLUDING MERCHANTABILITY AND FITNESS FOR
+   PURPOSE, ARE DISCLAIMED.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "TextFileLoader.h"
+#include "TextFileSearch.h"
+#include "SyntaxHighlighter.h"
+
+//==============================================================================
+/**
+    A read-only viewer for text files of any size.
+
+    Instead of copying the text into a TextEditor, the file is memory-mapped and
+    only a line-offset index is kept. Just the lines inside the visible window are
+    laid out and painted, so memory use and scrolling cost stay flat no matter how
+    big the file is.
+
+    The index is built by a TextFileLoader on a background thread, and the view
+    grows as each chunk of lines arrives, including lines appended to the file
+    while it's being followed.
+
+    Instead of the loader's word colours, the text can be coloured by a
+    SyntaxHighlighter. Each line is classified the first time it's painted, and
+    forgotten once it has scrolled out of view.
+
+    findText() searches the file with a TextFileSearch, also in the background.
+    Matches inside the visible lines are highlighted, and findNext() and
+    findPrevious() step through them without searching again.
+
+    The view records its own layout, style and paint times in the loader's
+    LoadTimings, and can draw all of the timings over the text.
+*/
+class TextFileView  : public juce::Component,
+                      private juce::ScrollBar::Listener
+{
+public:
+    TextFileView()
+    {
+        addAndMakeVisible (verticalScrollBar);
+        verticalScrollBar.setAutoHide (false);
+        verticalScrollBar.setSingleStepSize (1.0);
+        verticalScrollBar.addListener (this);
+
+        loader.onProgress = [this]
+        {
+            // When following a growing file, stay pinned to the end if that's
+            // where the view was before the new lines arrived.
+            auto wasShowingEnd = getFirstVisibleLine() + getNumVisibleLines() >= numLinesShown;
+
+            updateScrollBar();
+
+            if (loader.isFollowing() && wasShowingEnd)
+                scrollToLine (getNumLines() - getNumVisibleLines());
+
+            numLinesShown = getNumLines();
+
+            if (loader.isLoaded())
+                search.searchMore (loader.getSize());
+
+            repaint();
+        };
+
+        search.onProgress = [this]
+        {
+            repaint();
+
+            if (onSearchProgress != nullptr)
+                onSearchProgress();
+        };
+
+        setWantsKeyboardFocus (true);
+    }
+
+    ~TextFileView() override
+    {
+        verticalScrollBar.removeListener (this);
+    }
+
+    /** Starts loading a file in the background. Returns false if it couldn't be opened. */
+    bool loadFile (const juce::File& file)
+    {
+        clear();
+        currentFile = file;
+
+        return loader.load (file);
+    }
+
+    const juce::File& getFile() const noexcept      { return currentFile; }
+
+    void clear()
+    {
+        search.cancel();
+        currentMatch = -1;
+        highlightedLines.clear();
+        loader.cancel();
+        currentFile = juce::File();
+        numLinesShown = 0;
+        verticalScrollBar.setCurrentRangeStart (0.0);
+
+        updateScrollBar();
+        repaint();
+    }
+
+    /** Gives each word a random colour, like FileReadingTutorial_04. */
+    void setWordColouring (bool shouldColourWords)
+    {
+        if (shouldColourWords == loader.isWordColouring())
+            return;
+
+        auto file = currentFile;
+        auto textToFind = search.getSearchText();
+        clear();
+        loader.setWordColouring (shouldColourWords);
+
+        if (file != juce::File())
+        {
+            loadFile (file);
+            findText (textToFind);
+        }
+    }
+
+    /** Limits the memory used to view a file (see TextFileLoader::setMemoryBudget()),
+        or with 0 maps the whole file.
+    */
+    void setMemoryBudget (size_t numBytes)
+    {
+        if (numBytes == loader.getMemoryBudget())
+            return;
+
+        auto file = currentFile;
+        auto textToFind = search.getSearchText();
+        clear();
+        loader.setMemoryBudget (numBytes);
+        search.setMemoryBudget (numBytes);
+
+        if (file != juce::File())
+        {
+            loadFile (file);
+            findText (textToFind);
+        }
+    }
+
+    /** Colours the text with a set of rules rather than the loader's word colours,
+        or stops doing so if the highlighter is null.
+    */
+    void setSyntaxHighlighter (std::shared_ptr<const SyntaxHighlighter> newHighlighter)
+    {
+        highlighter = std::move (newHighlighter);
+        highlightedLines.clear();
+        repaint();
+    }
+
+    /** Shows or hides the per-stage timings of the current file over the text. */
+    void setShowingTimings (bool shouldShow)
+    {
+        showTimings = shouldShow;
+        repaint();
+    }
+
+    const LoadTimings& getTimings() const noexcept  { return loader.getTimings(); }
+
+    /** In follow mode, text that's appended to the file is shown as it arrives. */
+    void setFollowing (bool shouldFollow)
+    {
+        loader.setFollowing (shouldFollow);
+    }
+
+    /** Returns true once the whole file has been indexed. */
+    bool isLoaded() const noexcept                 { return loader.isLoaded(); }
+
+    juce::int64 getNumLines() const noexcept       { return loader.getNumLines(); }
+
+    void setFont (const juce::Font& newFont)
+    {
+        font = newFont;
+        updateScrollBar();
+        repaint();
+    }
+
+    const juce::Font& getFont() const noexcept     { return font; }
+
+    void scrollToLine (juce::int64 lineIndexToShow)
+    {
+        verticalScrollBar.setCurrentRangeStart ((double) lineIndexToShow);
+    }
+
+    //==============================================================================
+    /** Starts searching the file for some text, replacing any previous search.
+        Matches are highlighted as they're found.
+    */
+    void findText (const juce::String& textToFind)
+    {
+        search.start (currentFile, textToFind, loader.getSize());
+        currentMatch = -1;
+        repaint();
+    }
+
+    /** Moves to the next match, wrapping round at the end of the file. If no match
+        has been chosen yet, it's the first one below the top of the view. Returns
+        false if there aren't any matches (yet).
+    */
+    bool findNext()                                 { return moveToMatch (true); }
+
+    /** Moves to the previous match, wrapping round at the start of the file. */
+    bool findPrevious()                             { return moveToMatch (false); }
+
+    bool isSearching() const                        { return search.isSearching(); }
+    size_t getNumMatches() const noexcept           { return search.getMatches().size(); }
+
+    /** Returns the index of the match that was last moved to, or -1. */
+    juce::int64 getCurrentMatchIndex() const noexcept   { return currentMatch; }
+
+    /** Called each time more matches have been found. */
+    std::function<void()> onSearchProgress;
+
+    //==============================================================================
+    juce::int64 getFirstVisibleLine() const
+    {
+        return (juce::int64) verticalScrollBar.getCurrentRangeStart();
+    }
+
+    int getNumVisibleLines() const
+    {
+        return juce::jmax (1, getTextArea().getHeight() / getLineHeight());
+    }
+
+    //==============================================================================
+    void paint (juce::Graphics& g) override
+    {
+        auto& timings = loader.getTimings();
+        auto area = getTextArea();
+        auto firstLine = getFirstVisibleLine();
+        auto lastLine  = juce::jmin (getNumLines(), firstLine + getNumVisibleLines() + 1);
+        juce::int64 numBytesShown = 0;
+
+        // The lines are laid out and styled before any drawing, so that each
+        // stage can be timed separately.
+        {
+            LoadTimings::ScopedTimer timer (timings, LoadTimings::Stage::layout);
+            visibleRanges.clear();
+
+            for (auto line = firstLine; line < lastLine; ++line)
+            {
+                visibleRanges.push_back (getDisplayedRange (line));
+                numBytesShown += visibleRanges.back().getLength();
+            }
+
+            timer.numBytes = numBytesShown;
+        }
+
+        visibleRuns.assign (visibleRanges.size(), &loader.getStyleRuns());
+
+        if (highlighter != nullptr)
+        {
+            LoadTimings::ScopedTimer timer (timings, LoadTimings::Stage::style, numBytesShown);
+
+            for (size_t i = 0; i < visibleRanges.size(); ++i)
+                visibleRuns[i] = &getSyntaxRuns (firstLine + (juce::int64) i, visibleRanges[i]);
+
+            highlightedLines.erase (highlightedLines.begin(), highlightedLines.lower_bound (firstLine));
+            highlightedLines.erase (highlightedLines.lower_bound (lastLine), highlightedLines.end());
+        }
+
+        {
+            LoadTimings::ScopedTimer timer (timings, LoadTimings::Stage::paint, numBytesShown);
+
+            g.fillAll (findColour (juce::TextEditor::backgroundColourId));
+            g.reduceClipRegion (area);
+
+            auto y = area.getY();
+
+            for (size_t i = 0; i < visibleRanges.size(); ++i, y += getLineHeight())
+            {
+                drawMatches (g, visibleRanges[i], (float) area.getX(), y);
+                drawLine (g, visibleRanges[i], *visibleRuns[i], (float) area.getX(), y);
+            }
+        }
+
+        if (showTimings)
+            drawTimings (g, area);
+    }
+
+    void resized() override
+    {
+        auto scrollBarWidth = getLookAndFeel().getDefaultScrollbarWidth();
+        verticalScrollBar.setBounds (getLocalBounds().removeFromRight (scrollBarWidth));
+
+        updateScrollBar();
+    }
+
+    void mouseWheelMove (const juce::MouseEvent& e, const juce::MouseWheelDetails& wheel) override
+    {
+        verticalScrollBar.mouseWheelMove (e, wheel);
+    }
+
+    bool keyPressed (const juce::KeyPress& key) override
+    {
+        return verticalScrollBar.keyPressed (key);
+    }
+
+private:
+    void scrollBarMoved (juce::ScrollBar*, double newRangeStart) override
+    {
+        auto scrollingDown = newRangeStart >= lastScrollPosition;
+        lastScrollPosition = newRangeStart;
+
+        // Starts reading whatever is about to scroll into view.
+        if (getNumLines() > 0)
+        {
+            auto edgeLine = scrollingDown ? juce::jmin (getNumLines(), getFirstVisibleLine() + getNumVisibleLines()) - 1
+                                          : getFirstVisibleLine();
+
+            loader.prefetch (loader.getLineRange (edgeLine).getStart(), scrollingDown);
+        }
+
+        repaint();
+    }
+
+    void updateScrollBar()
+    {
+        auto numVisible = (double) getNumVisibleLines();
+
+        verticalScrollBar.setRangeLimits (0.0, juce::jmax ((double) getNumLines(), numVisible));
+        verticalScrollBar.setCurrentRange (verticalScrollBar.getCurrentRangeStart(), numVisible);
+    }
+
+    juce::Rectangle<int> getTextArea() const
+    {
+        return getLocalBounds().withTrimmedRight (verticalScrollBar.getWidth()).reduced (4, 2);
+    }
+
+    int getLineHeight() const
+    {
+        return juce::jmax (1, (int) std::ceil (font.getHeight()));
+    }
+
+    // Draws each styled run of a line in turn, so the whole visible window is
+    // painted in a single pass however many runs the file contains.
+    void drawLine (juce::Graphics& g, juce::Range<juce::int64> range, const TextStyleRuns& styleRuns, float x, int y) const
+    {
+        auto* data = loader.getBytes (range);
+        auto defaultColour = findColour (juce::TextEditor::textColourId);
+
+        styleRuns.forEachRun (range, [&] (juce::Range<juce::int64> piece, juce::Colour colour, int fontStyleFlags)
+        {
+            auto text = juce::String::fromUTF8 (data + (piece.getStart() - range.getStart()), (int) piece.getLength());
+            auto pieceFont = font.withStyle (fontStyleFlags);
+            auto width = pieceFont.getStringWidthFloat (text);
+
+            g.setColour (colour.isTransparent() ? defaultColour : colour);
+            g.setFont (pieceFont);
+            g.drawText (text, juce::Rectangle<float> (x, (float) y, width, (float) getLineHeight()),
+                        juce::Justification::centredLeft, false);
+            x += width;
+        });
+    }
+
+    // A line's range changes if text is appended to it, in which case it has to
+    // be classified again.
+    const TextStyleRuns& getSyntaxRuns (juce::int64 line, juce::Range<juce::int64> range)
+    {
+        auto& highlighted = highlightedLines[line];
+
+        if (highlighted.runs.isEmpty() || highlighted.range != range)
+        {
+            highlighted.range = range;
+            highlighted.runs.clear();
+            highlighted.runs.addRun ({ range.getStart(), 0, juce::Font::plain });
+
+            auto state = highlighter->startLine (range.getStart());
+            highlighter->highlight (loader.getBytes (range), (size_t) range.getLength(), range.getStart(), state, highlighted.runs);
+            highlighter->finish (state, range.getEnd(), highlighted.runs);
+        }
+
+        return highlighted.runs;
+    }
+
+    void drawTimings (juce::Graphics& g, juce::Rectangle<int> area) const
+    {
+        auto lines = loader.getTimings().getSummaryLines();
+        auto timingsFont = font.withHeight (12.0f);
+        auto lineHeight = (int) std::ceil (timingsFont.getHeight());
+
+        auto width = 0;
+
+        for (auto& line : lines)
+            width = juce::jmax (width, timingsFont.getStringWidth (line));
+
+        auto box = area.removeFromTop (lines.size() * lineHeight + 8)
+                       .removeFromRight (width + 12);
+
+        g.setColour (juce::Colours::black.withAlpha (0.75f));
+        g.fillRect (box);
+
+        g.setColour (juce::Colours::white);
+        g.setFont (timingsFont);
+        box.reduce (6, 4);
+
+        for (auto& line : lines)
+            g.drawText (line, box.removeFromTop (lineHeight), juce::Justification::centredLeft, false);
+    }
+
+    // Highlights the parts of a line covered by search matches, including one
+    // that started on an earlier line.
+    void drawMatches (juce::Graphics& g, juce::Range<juce::int64> range, float x, int y) const
+    {
+        auto& matches = search.getMatches();
+        auto matchLength = (juce::int64) search.getMatchLength();
+        auto first = search.findFirstMatchFrom (range.getStart() - matchLength + 1);
+
+        if (range.isEmpty() || first == matches.size() || matches[first] >= range.getEnd())
+            return;
+
+        auto* data = loader.getBytes (range);
+
+        auto getWidth = [&] (juce::int64 start, juce::int64 end)
+        {
+            return font.getStringWidthFloat (juce::String::fromUTF8 (data + (start - range.getStart()), (int) (end - start)));
+        };
+
+        for (auto i = first; i < matches.size() && matches[i] < range.getEnd(); ++i)
+        {
+            auto hit = range.getIntersectionWith ({ matches[i], matches[i] + matchLength });
+
+            if (hit.isEmpty())
+                continue;
+
+            g.setColour ((juce::int64) i == currentMatch ? juce::Colours::orange
+                                                         : findColour (juce::TextEditor::highlightColourId));
+            g.fillRect (juce::Rectangle<float> (x + getWidth (range.getStart(), hit.getStart()), (float) y,
+                                                getWidth (hit.getStart(), hit.getEnd()), (float) getLineHeight()));
+        }
+    }
+
+    bool moveToMatch (bool forward)
+    {
+        auto& matches = search.getMatches();
+        auto numMatches = (juce::int64) matches.size();
+
+        if (numMatches == 0 || getNumLines() == 0)
+            return false;
+
+        if (currentMatch < 0)
+        {
+            auto topOfView = loader.getLineRange (getFirstVisibleLine()).getStart();
+            auto next = (juce::int64) search.findFirstMatchFrom (topOfView);
+
+            currentMatch = forward ? next % numMatches
+                                   : (next + numMatches - 1) % numMatches;
+        }
+        else
+        {
+            currentMatch = (currentMatch + (forward ? 1 : numMatches - 1)) % numMatches;
+        }
+
+        auto line = loader.getLineContaining (matches[(size_t) currentMatch]);
+        auto firstVisible = getFirstVisibleLine();
+
+        if (line < firstVisible || line >= firstVisible + getNumVisibleLines())
+            scrollToLine (line - getNumVisibleLines() / 2);
+
+        repaint();
+        return true;
+    }
+
+    juce::Range<juce::int64> getDisplayedRange (juce::int64 line) const
+    {
+        return TextLineIndex::getDisplayedRange (loader.getLineRange (line),
+                                                 [this] (juce::Range<juce::int64> range) { return loader.getBytes (range); });
+    }
+
+    TextFileLoader loader;
+    TextFileSearch search;
+    juce::int64 currentMatch = -1;
+    juce::File currentFile;
+    juce::int64 numLinesShown = 0;
+    double lastScrollPosition = 0.0;
+
+    struct HighlightedLine
+    {
+        juce::Range<juce::int64> range;
+        TextStyleRuns runs;
+    };
+
+    std::shared_ptr<const SyntaxHighlighter> highlighter;
+    std::map<juce::int64, HighlightedLine> highlightedLines;   // only the visible ones
+
+    std::vector<juce::Range<juce::int64>> visibleRanges;       // reused by each paint
+    std::vector<const TextStyleRuns*> visibleRuns;
+    bool showTimings = false;
+
+    juce::Font font { juce::Font::getDefaultMonospacedFontName(), 14.0f, juce::Font::plain };
+    juce::ScrollBar verticalScrollBar { true };
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TextFileView)
+};
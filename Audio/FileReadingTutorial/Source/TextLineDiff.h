@@ -0,0 +1,453 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE tutorials.
+   Copyright (c) 2020 - Raw Material Software Limited
+
+   The code included in this file is provided under the terms of the ISC license
+   http://www.isc.org/downloads/software-support-policy/isc-license. Permission
+   To use, copy, modify, and/or distribute this software for any purpose with or
+   without fee is hereby granted provided that the above copyright notice and
+   this permission notice appear in all copies.
+
+   THE SOFTWARE IS PROVIDED "AS IS" WITHOUT ANY WARRANTY, AND ALL WARRANTIES,
+   WHETHER EXPRESSED OR IMPLIED, INCLUDING MERCHANTABILITY AND FITNESS FOR
+   PURPOSE, ARE DISCLAIMED.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+//==============================================================================
+/**
+    Finds the lines that differ between two texts, working on line hashes.
+
+    Each line is reduced to a 64-bit hash first, so the diff itself never looks
+    at the text, and the memory it uses depends on the number of lines rather
+    than the number of bytes. Two different lines with the same hash would be
+    treated as equal, which is unlikely enough to ignore for a viewer.
+
+    The diff is Myers' O(ND) algorithm in its linear-space form, which finds the
+    middle of the shortest edit path from both ends at once and recurses either
+    side of it. Before that, as in git's xdiff:
+
+    - the common prefix and suffix of each region are skipped, and
+    - lines that don't appear anywhere in the other text are taken out, as they
+      can only be changes. In logs, where most lines carry a timestamp, this
+      usually leaves very little for Myers to do.
+
+    If a region would cost more than about the square root of its size to diff
+    exactly, it's split at the furthest point reached instead, so the result is
+    still a valid diff but not always the smallest one.
+*/
+struct TextLineDiff
+{
+    /** A run of lines that differ: numA lines from startA in the first text were
+        replaced by numB lines from startB in the second.
+    */
+    struct Hunk
+    {
+        juce::int64 startA, numA, startB, numB;
+    };
+
+    /** Hashes a line, ignoring its line ending. */
+    static juce::uint64 hashLine (const char* data, size_t numBytes) noexcept
+    {
+        while (numBytes > 0 && (data[numBytes - 1] == '\n' || data[numBytes - 1] == '\r'))
+            --numBytes;
+
+        auto hash = 0x9e3779b97f4a7c15ull ^ (juce::uint64) numBytes;
+        size_t i = 0;
+
+        for (; i + 8 <= numBytes; i += 8)
+        {
+            juce::uint64 word;
+            std::memcpy (&word, data + i, 8);
+            hash = (hash ^ word) * 0xff51afd7ed558ccdull;
+            hash ^= hash >> 32;
+        }
+
+        juce::uint64 tail = 0;
+        std::memcpy (&tail, data + i, numBytes - i);
+        hash = (hash ^ tail) * 0xc4ceb9fe1a85ec53ull;
+        return hash ^ (hash >> 29);
+    }
+
+    /** Finds the lines that start in [start, end) of some text, appending their
+        offsets and hashes. A line belongs to the block containing the newline
+        before it, so a text split into consecutive blocks (e.g. one per thread)
+        gives every line exactly once.
+    */
+    static void hashLines (const char* data, size_t size, size_t start, size_t end,
+                           std::vector<juce::int64>& lineStarts, std::vector<juce::uint64>& hashes)
+    {
+        size_t lineStart;
+
+        if (start == 0)
+        {
+            lineStart = 0;
+        }
+        else
+        {
+            auto* newLine = static_cast<const char*> (std::memchr (data + start, '\n', end - start));
+
+            if (newLine == nullptr)
+                return;
+
+            lineStart = (size_t) (newLine - data) + 1;
+        }
+
+        while (lineStart < size)
+        {
+            auto* newLine = static_cast<const char*> (std::memchr (data + lineStart, '\n', size - lineStart));
+            auto lineEnd = newLine != nullptr ? (size_t) (newLine - data) + 1 : size;
+
+            lineStarts.push_back ((juce::int64) lineStart);
+            hashes.push_back (hashLine (data + lineStart, lineEnd - lineStart));
+
+            if (lineEnd > end)
+                break;
+
+            lineStart = lineEnd;
+        }
+    }
+
+    //==============================================================================
+    /** Compares two lists of line hashes, returning the hunks in order. Returns
+        an empty list if shouldStop() returns true part-way through.
+    */
+    static std::vector<Hunk> compare (const std::vector<juce::uint64>& a,
+                                      const std::vector<juce::uint64>& b,
+                                      const std::function<bool()>& shouldStop = nullptr)
+    {
+        std::vector<char> changedA (a.size(), 0), changedB (b.size(), 0);
+
+        // Lines found in only one of the texts are changed, and are left out of
+        // the sequences that Myers works on.
+        std::vector<juce::int64> keptA, keptB;
+        std::vector<juce::uint64> reducedA, reducedB;
+        discardUnmatchedLines (a, b, changedA, keptA, reducedA);
+        discardUnmatchedLines (b, a, changedB, keptB, reducedB);
+
+        std::vector<char> reducedChangedA (reducedA.size(), 0), reducedChangedB (reducedB.size(), 0);
+
+        if (! Myers (reducedA, reducedB, reducedChangedA, reducedChangedB).run (shouldStop))
+            return {};
+
+        for (size_t i = 0; i < keptA.size(); ++i)
+            changedA[(size_t) keptA[i]] = reducedChangedA[i];
+
+        for (size_t i = 0; i < keptB.size(); ++i)
+            changedB[(size_t) keptB[i]] = reducedChangedB[i];
+
+        return makeHunks (changedA, changedB);
+    }
+
+private:
+    //==============================================================================
+    // An open-addressing set of hashes, sized for the number of lines.
+    struct HashSet
+    {
+        explicit HashSet (const std::vector<juce::uint64>& hashes)
+        {
+            size_t capacity = 16;
+
+            while (capacity < hashes.size() * 2)
+                capacity *= 2;
+
+            slots.resize (capacity, 0);
+            mask = capacity - 1;
+
+            for (auto hash : hashes)
+            {
+                auto key = toKey (hash);
+                auto i = (size_t) (key * 0x9e3779b97f4a7c15ull) & mask;
+
+                while (slots[i] != 0 && slots[i] != key)
+                    i = (i + 1) & mask;
+
+                slots[i] = key;
+            }
+        }
+
+        bool contains (juce::uint64 hash) const noexcept
+        {
+            auto key = toKey (hash);
+
+            for (auto i = (size_t) (key * 0x9e3779b97f4a7c15ull) & mask; slots[i] != 0; i = (i + 1) & mask)
+                if (slots[i] == key)
+                    return true;
+
+            return false;
+        }
+
+        // 0 marks an empty slot.
+        static juce::uint64 toKey (juce::uint64 hash) noexcept    { return hash != 0 ? hash : 1; }
+
+        std::vector<juce::uint64> slots;
+        size_t mask = 0;
+    };
+
+    static void discardUnmatchedLines (const std::vector<juce::uint64>& lines,
+                                       const std::vector<juce::uint64>& otherLines,
+                                       std::vector<char>& changed,
+                                       std::vector<juce::int64>& kept,
+                                       std::vector<juce::uint64>& reduced)
+    {
+        HashSet otherSet (otherLines);
+
+        for (size_t i = 0; i < lines.size(); ++i)
+        {
+            if (otherSet.contains (lines[i]))
+            {
+                kept.push_back ((juce::int64) i);
+                reduced.push_back (lines[i]);
+            }
+            else
+            {
+                changed[i] = 1;
+            }
+        }
+    }
+
+    static std::vector<Hunk> makeHunks (const std::vector<char>& changedA, const std::vector<char>& changedB)
+    {
+        std::vector<Hunk> hunks;
+        auto n = (juce::int64) changedA.size(), m = (juce::int64) changedB.size();
+        juce::int64 i = 0, j = 0;
+
+        while (i < n || j < m)
+        {
+            if ((i < n && changedA[(size_t) i] != 0) || (j < m && changedB[(size_t) j] != 0))
+            {
+                Hunk hunk { i, 0, j, 0 };
+
+                while (i < n && changedA[(size_t) i] != 0)  ++i;
+                while (j < m && changedB[(size_t) j] != 0)  ++j;
+
+                hunk.numA = i - hunk.startA;
+                hunk.numB = j - hunk.startB;
+                hunks.push_back (hunk);
+            }
+            else
+            {
+                ++i;
+                ++j;
+            }
+        }
+
+        return hunks;
+    }
+
+    //==============================================================================
+    struct Myers
+    {
+        Myers (const std::vector<juce::uint64>& aToUse, const std::vector<juce::uint64>& bToUse,
+               std::vector<char>& changedAToUse, std::vector<char>& changedBToUse)
+            : a (aToUse), b (bToUse), changedA (changedAToUse), changedB (changedBToUse)
+        {
+        }
+
+        // The regions still to be compared are kept on a stack rather than
+        // recursing, as a long diff can split many times.
+        bool run (const std::function<bool()>& shouldStop)
+        {
+            std::vector<Region> regions { { 0, (juce::int64) a.size(), 0, (juce::int64) b.size() } };
+
+            while (! regions.empty())
+            {
+                if (shouldStop != nullptr && shouldStop())
+                    return false;
+
+                auto region = regions.back();
+                regions.pop_back();
+
+                while (region.startA < region.endA && region.startB < region.endB
+                        && a[(size_t) region.startA] == b[(size_t) region.startB])
+                {
+                    ++region.startA;
+                    ++region.startB;
+                }
+
+                while (region.startA < region.endA && region.startB < region.endB
+                        && a[(size_t) region.endA - 1] == b[(size_t) region.endB - 1])
+                {
+                    --region.endA;
+                    --region.endB;
+                }
+
+                if (region.startA == region.endA || region.startB == region.endB)
+                {
+                    markChanged (region);
+                    continue;
+                }
+
+                juce::int64 splitA, splitB;
+
+                // A split that makes no progress would loop forever.
+                if (! findSplit (region, splitA, splitB)
+                     || (splitA == region.startA && splitB == region.startB)
+                     || (splitA == region.endA && splitB == region.endB))
+                {
+                    markChanged (region);
+                    continue;
+                }
+
+                regions.push_back ({ region.startA, splitA, region.startB, splitB });
+                regions.push_back ({ splitA, region.endA, splitB, region.endB });
+            }
+
+            return true;
+        }
+
+    private:
+        struct Region
+        {
+            juce::int64 startA, endA, startB, endB;
+        };
+
+        void markChanged (const Region& region)
+        {
+            std::fill (changedA.begin() + region.startA, changedA.begin() + region.endA, (char) 1);
+            std::fill (changedB.begin() + region.startB, changedB.begin() + region.endB, (char) 1);
+        }
+
+        // Follows the forward and reverse paths until they overlap, giving a point
+        // that the shortest edit path passes through. Returns false if the region
+        // can't be usefully split.
+        bool findSplit (const Region& region, juce::int64& splitA, juce::int64& splitB)
+        {
+            auto n = region.endA - region.startA;
+            auto m = region.endB - region.startB;
+            auto* x = a.data() + region.startA;
+            auto* y = b.data() + region.startB;
+
+            auto maxD = juce::jmin ((n + m + 1) / 2, getMaximumCost (n + m));
+            auto offset = maxD + 1;
+            auto length = (size_t) (2 * offset + 1);
+            auto delta = n - m;
+            auto front = (delta % 2) != 0;
+
+            forward.assign (length, -1);
+            reverse.assign (length, -1);
+            forward[(size_t) offset + 1] = 0;
+            reverse[(size_t) offset + 1] = 0;
+
+            juce::int64 kStartF = 0, kEndF = 0, kStartR = 0, kEndR = 0;
+
+            for (juce::int64 d = 0; d < maxD; ++d)
+            {
+                for (auto k = -d + kStartF; k <= d - kEndF; k += 2)
+                {
+                    auto index = (size_t) (offset + k);
+                    auto xf = (k == -d || (k != d && forward[index - 1] < forward[index + 1])) ? forward[index + 1]
+                                                                                               : forward[index - 1] + 1;
+                    auto yf = xf - k;
+
+                    while (xf < n && yf < m && x[xf] == y[yf])
+                    {
+                        ++xf;
+                        ++yf;
+                    }
+
+                    forward[index] = xf;
+
+                    if (xf > n)
+                    {
+                        kEndF += 2;
+                    }
+                    else if (yf > m)
+                    {
+                        kStartF += 2;
+                    }
+                    else if (front)
+                    {
+                        auto reverseIndex = offset + delta - k;
+
+                        if (reverseIndex >= 0 && reverseIndex < (juce::int64) length && reverse[(size_t) reverseIndex] != -1
+                             && xf >= n - reverse[(size_t) reverseIndex])
+                            return setSplit (region, xf, yf, splitA, splitB);
+                    }
+                }
+
+                for (auto k = -d + kStartR; k <= d - kEndR; k += 2)
+                {
+                    auto index = (size_t) (offset + k);
+                    auto xr = (k == -d || (k != d && reverse[index - 1] < reverse[index + 1])) ? reverse[index + 1]
+                                                                                               : reverse[index - 1] + 1;
+                    auto yr = xr - k;
+
+                    while (xr < n && yr < m && x[n - xr - 1] == y[m - yr - 1])
+                    {
+                        ++xr;
+                        ++yr;
+                    }
+
+                    reverse[index] = xr;
+
+                    if (xr > n)
+                    {
+                        kEndR += 2;
+                    }
+                    else if (yr > m)
+                    {
+                        kStartR += 2;
+                    }
+                    else if (! front)
+                    {
+                        auto forwardIndex = offset + delta - k;
+
+                        if (forwardIndex >= 0 && forwardIndex < (juce::int64) length && forward[(size_t) forwardIndex] != -1)
+                        {
+                            auto xf = forward[(size_t) forwardIndex];
+                            auto yf = offset + xf - forwardIndex;
+
+                            if (xf >= n - xr)
+                                return setSplit (region, xf, yf, splitA, splitB);
+                        }
+                    }
+                }
+            }
+
+            // Too expensive to finish: split at the forward path that got furthest.
+            juce::int64 bestX = 0, bestY = 0;
+
+            for (auto k = -maxD; k <= maxD; ++k)
+            {
+                auto xf = forward[(size_t) (offset + k)];
+                auto yf = xf - k;
+
+                if (xf >= 0 && xf <= n && yf >= 0 && yf <= m && xf + yf > bestX + bestY)
+                {
+                    bestX = xf;
+                    bestY = yf;
+                }
+            }
+
+            if (bestX + bestY == 0 || (bestX == n && bestY == m))
+                return false;
+
+            return setSplit (region, bestX, bestY, splitA, splitB);
+        }
+
+        static bool setSplit (const Region& region, juce::int64 x, juce::int64 y, juce::int64& splitA, juce::int64& splitB)
+        {
+            splitA = region.startA + x;
+            splitB = region.startB + y;
+            return true;
+        }
+
+        // Like xdiff, the cost is limited to roughly the square root of the size.
+        static juce::int64 getMaximumCost (juce::int64 size)
+        {
+            return juce::jmax ((juce::int64) 256, (juce::int64) std::sqrt ((double) size));
+        }
+
+        const std::vector<juce::uint64>& a;
+        const std::vector<juce::uint64>& b;
+        std::vector<char>& changedA;
+        std::vector<char>& changedB;
+        std::vector<juce::int64> forward, reverse;
+    };
+};
@@ -0,0 +1,276 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE tutorials.
+   Copyright (c) 2020 - Raw Material Software Limited
+
+   The code included in this file is provided under the terms of the ISC license
+   http://www.isc.org/downloads/software-support-policy/isc-license. Permission
+   To use, copy, modify, and/or distribute this software for any purpose with or
+   without fee is hereby granted provided that the above copyright notice and
+   this permission notice appear in all copies.
+
+   THE SOFTWARE IS PROVIDED "AS IS" WITHOUT ANY WARRANTY, AND ALL WARRANTIES,
+   WHETHER EXPRESSED OR IMPLIED, INCLUDING MERCHANTABILITY AND FITNESS FOR
+   PURPOSE, ARE DISCLAIMED.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "TextScanner.h"
+
+//==============================================================================
+/**
+    Keeps the byte offset at which each line of a block of text starts.
+
+    The text itself isn't copied, so it can stay wherever it already lives (for
+    example in a MemoryMappedFile) and any line can be located in constant time.
+
+    The offsets are stored as the list of line breaks (the position after each
+    newline). Those can live in a vector owned by the index, or in storage shared
+    with something else, such as a memory-mapped cache file, followed by any
+    breaks that have been appended since.
+
+    To put a hard limit on memory use, the index can instead keep just a sample of
+    the breaks: every other one, then every fourth, and so on, as more arrive.
+    The lines in between then have to be found by scanning the text forwards from
+    the nearest line whose start is known.
+*/
+class TextLineIndex
+{
+public:
+    TextLineIndex() = default;
+
+    /** A line whose starting offset is known. */
+    struct LineStart
+    {
+        juce::int64 line, offset;
+    };
+
+    /** Rebuilds the index for a block of text. */
+    void build (const char* data, size_t numBytes)
+    {
+        clear();
+        append (data, numBytes);
+    }
+
+    /** Indexes some more text which directly follows what's already been indexed. */
+    void append (const char* newData, size_t numBytes)
+    {
+        if (maximumNumBreaks > 0)
+        {
+            std::vector<juce::int64> newLineBreaks;
+            TextScanner::findBreaks (newData, numBytes, (juce::int64) totalBytes, newLineBreaks);
+            appendBreaks (newLineBreaks, totalBytes + numBytes);
+            return;
+        }
+
+        TextScanner::findBreaks (newData, numBytes, (juce::int64) totalBytes, lineBreaks);
+        totalBytes += numBytes;
+    }
+
+    /** Adds line breaks that were found elsewhere (e.g. on a background thread).
+        The breaks must be in order, and newTotalBytes is the amount of text that
+        has now been scanned.
+    */
+    void appendBreaks (const std::vector<juce::int64>& newLineBreaks, size_t newTotalBytes)
+    {
+        jassert (newTotalBytes >= totalBytes);
+
+        if (maximumNumBreaks > 0)
+        {
+            for (auto lineBreak : newLineBreaks)
+                if (++numBreaksSeen % stride == 0)
+                    lineBreaks.push_back (lineBreak);
+
+            if (! newLineBreaks.empty())
+                lastBreak = newLineBreaks.back();
+
+            while (lineBreaks.size() > maximumNumBreaks)
+                discardHalfOfTheBreaks();
+        }
+        else
+        {
+            lineBreaks.insert (lineBreaks.end(), newLineBreaks.begin(), newLineBreaks.end());
+        }
+
+        totalBytes = newTotalBytes;
+    }
+
+    /** Limits the number of line breaks that are kept in memory, or with 0 keeps
+        them all. This has to be set while the index is empty, and can't be
+        combined with setSharedBreaks().
+    */
+    void setMaximumNumBreaks (size_t maximum)
+    {
+        jassert (totalBytes == 0);
+
+        maximumNumBreaks = maximum;
+        lineBreaks.reserve (maximum + 1);  // so the vector never grows past the limit
+    }
+
+    /** Returns true if only some of the line breaks have been kept, in which case
+        getLineRange() can't be used.
+    */
+    bool isSampled() const noexcept                { return stride > 1; }
+
+    /** Replaces the index with breaks held in some external storage, which is kept
+        alive by the given owner for as long as the index refers to it.
+    */
+    void setSharedBreaks (std::shared_ptr<const void> owner, const juce::int64* breaks,
+                          size_t numBreaks, size_t newTotalBytes)
+    {
+        clear();
+        jassert (maximumNumBreaks == 0);
+
+        sharedStorage   = std::move (owner);
+        sharedBreaks    = breaks;
+        numSharedBreaks = numBreaks;
+        totalBytes      = newTotalBytes;
+    }
+
+    void clear()
+    {
+        lineBreaks.clear();
+        sharedStorage.reset();
+        sharedBreaks = nullptr;
+        numSharedBreaks = 0;
+        totalBytes = 0;
+        numBreaksSeen = 0;
+        lastBreak = 0;
+        stride = 1;
+    }
+
+    juce::int64 getNumLines() const noexcept
+    {
+        if (totalBytes == 0)
+            return 0;
+
+        // A trailing newline doesn't start another line until more text arrives.
+        auto numBreaks = getNumBreaks();
+        auto numStarts = (juce::int64) numBreaks + 1;
+
+        return numBreaks > 0 && getLastBreak() == (juce::int64) totalBytes ? numStarts - 1 : numStarts;
+    }
+
+    size_t getTotalBytes() const noexcept          { return totalBytes; }
+
+    /** Returns the byte range of a line, including its line-ending characters. */
+    juce::Range<juce::int64> getLineRange (juce::int64 lineIndex) const noexcept
+    {
+        jassert (juce::isPositiveAndBelow (lineIndex, getNumLines()) && ! isSampled());
+
+        auto start = lineIndex == 0 ? 0 : getBreak ((size_t) lineIndex - 1);
+        auto end   = (size_t) lineIndex < getNumBreaks() ? getBreak ((size_t) lineIndex)
+                                                         : (juce::int64) totalBytes;
+        return { start, end };
+    }
+
+    /** Returns the part of a line that a view displays: the line ending is left
+        out, and a very long line is cut short (on a UTF-8 character boundary), so
+        a single enormous line can't make painting any slower than a normal one.
+
+        getBytes is called once, with a range at the start of the line, and must
+        return a pointer to the text in that range.
+    */
+    template <typename GetBytesFunction>
+    static juce::Range<juce::int64> getDisplayedRange (juce::Range<juce::int64> lineRange, GetBytesFunction&& getBytes)
+    {
+        auto start = lineRange.getStart();
+        auto end   = juce::jmin (lineRange.getEnd(), start + maxDisplayedBytesPerLine + 1);
+        const char* data = getBytes (juce::Range<juce::int64> (start, end));
+        auto byteAt = [&] (juce::int64 pos) { return data[pos - start]; };
+
+        if (end - start > maxDisplayedBytesPerLine)
+        {
+            end = start + maxDisplayedBytesPerLine;
+
+            while (end > start && (byteAt (end) & 0xc0) == 0x80)  // don't split a UTF-8 sequence
+                --end;
+        }
+
+        while (end > start && (byteAt (end - 1) == '\n' || byteAt (end - 1) == '\r'))
+            --end;
+
+        return { start, end };
+    }
+
+    static constexpr juce::int64 maxDisplayedBytesPerLine = 1024;
+
+    /** Returns the index of the line that contains a byte offset. */
+    juce::int64 getLineContaining (juce::int64 offset) const noexcept
+    {
+        jassert (getNumLines() > 0 && ! isSampled());
+
+        return juce::jmin (getNearestLineStartBefore (offset).line, getNumLines() - 1);
+    }
+
+    /** Returns the last line at or before lineIndex whose start is known. When
+        every break is kept, that's the line itself.
+    */
+    LineStart getNearestLineStart (juce::int64 lineIndex) const noexcept
+    {
+        auto numBreaksBefore = juce::jmin (lineIndex / stride, (juce::int64) getNumStoredBreaks());
+
+        if (numBreaksBefore == 0)
+            return { 0, 0 };
+
+        return { numBreaksBefore * stride, getBreak ((size_t) numBreaksBefore - 1) };
+    }
+
+    /** Returns the last line starting at or before an offset whose start is known. */
+    LineStart getNearestLineStartBefore (juce::int64 offset) const noexcept
+    {
+        auto numBreaksBefore = (std::upper_bound (sharedBreaks, sharedBreaks + numSharedBreaks, offset) - sharedBreaks)
+                             + (std::upper_bound (lineBreaks.begin(), lineBreaks.end(), offset) - lineBreaks.begin());
+
+        if (numBreaksBefore == 0)
+            return { 0, 0 };
+
+        return { (juce::int64) numBreaksBefore * stride, getBreak ((size_t) numBreaksBefore - 1) };
+    }
+
+private:
+    size_t getNumStoredBreaks() const noexcept     { return numSharedBreaks + lineBreaks.size(); }
+
+    size_t getNumBreaks() const noexcept
+    {
+        return maximumNumBreaks > 0 ? (size_t) numBreaksSeen : getNumStoredBreaks();
+    }
+
+    juce::int64 getLastBreak() const noexcept
+    {
+        return maximumNumBreaks > 0 ? lastBreak : getBreak (getNumStoredBreaks() - 1);
+    }
+
+    // The kept breaks are the starts of lines stride, 2 * stride, 3 * stride etc,
+    // so doubling the stride keeps every second one of them.
+    void discardHalfOfTheBreaks()
+    {
+        size_t numKept = 0;
+
+        for (size_t i = 1; i < lineBreaks.size(); i += 2)
+            lineBreaks[numKept++] = lineBreaks[i];
+
+        lineBreaks.resize (numKept);
+        stride *= 2;
+    }
+
+    juce::int64 getBreak (size_t i) const noexcept
+    {
+        return i < numSharedBreaks ? sharedBreaks[i] : lineBreaks[i - numSharedBreaks];
+    }
+
+    std::vector<juce::int64> lineBreaks;
+    std::shared_ptr<const void> sharedStorage;
+    const juce::int64* sharedBreaks = nullptr;
+    size_t numSharedBreaks = 0;
+    size_t totalBytes = 0;
+
+    size_t maximumNumBreaks = 0;
+    juce::int64 stride = 1, numBreaksSeen = 0, lastBreak = 0;
+
+    JUCE_LEAK_DETECTOR (TextLineIndex)
+};
@@ -0,0 +1,262 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE tutorials.
+   Copyright (c) 2020 - Raw Material Software Limited
+
+   The code included in this file is provided under the terms of the ISC license
+   http://www.isc.org/downloads/software-support-policy/isc-license. Permission
+   To use, copy, modify, and/or distribute this software for any purpose with or
+   without fee is hereby granted provided that the above copyright notice and
+   this permission notice appear in all copies.
+
+   THE SOFTWARE IS PROVIDED "AS IS" WITHOUT ANY WARRANTY, AND ALL WARRANTIES,
+   WHETHER EXPRESSED OR IMPLIED, INCLUDING MERCHANTABILITY AND FITNESS FOR
+   PURPOSE, ARE DISCLAIMED.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+//==============================================================================
+/**
+    Saves the line breaks of a text file to a compact binary file in a cache
+    directory, so that reopening a file that's been seen before doesn't need to
+    scan it again.
+
+    Cache files are named after a hash of the text file's path. Each one starts
+    with a fixed-size header recording the size and modification time of the file
+    it was built from, followed by the break offsets as raw 64-bit integers, so it
+    can be memory-mapped straight back into a TextLineIndex.
+
+    A cache file is ignored (and later rebuilt) if the text file's size or time has
+    changed, if the header's checksum doesn't match, if its length is wrong, if its
+    offsets aren't all in order and inside the text, or if a sample of them don't
+    land just after a newline in the actual text.
+*/
+struct TextLineIndexCache
+{
+    /** A cached index that has been mapped into memory. */
+    struct MappedBreaks
+    {
+        std::shared_ptr<juce::MemoryMappedFile> mapping;
+        const juce::int64* breaks = nullptr;
+        size_t numBreaks = 0;
+        size_t textSize = 0;
+    };
+
+    static juce::File getCacheDirectory()
+    {
+        return juce::File::getSpecialLocation (juce::File::userApplicationDataDirectory)
+                   .getChildFile ("FileReadingTutorial")
+                   .getChildFile ("LineIndexCache");
+    }
+
+    static juce::File getCacheFileFor (const juce::File& textFile)
+    {
+        return getCacheDirectory().getChildFile (juce::String::toHexString (textFile.getFullPathName().hashCode64())
+                                                   + ".lineindex");
+    }
+
+    /** Maps the cached breaks for a text file, or returns an empty result if there's
+        no valid cache for it. The text must be the file's current contents.
+    */
+    static MappedBreaks load (const juce::File& textFile, const char* text, size_t textSize)
+    {
+        auto cacheFile = getCacheFileFor (textFile);
+
+        if (! cacheFile.existsAsFile())
+            return {};
+
+        auto mapping = std::make_shared<juce::MemoryMappedFile> (cacheFile, juce::MemoryMappedFile::readOnly);
+
+        if (mapping->getData() == nullptr || mapping->getSize() < sizeof (Header))
+            return {};
+
+        Header header;
+        std::memcpy (&header, mapping->getData(), sizeof (Header));
+
+        if (! header.matches (textFile, textSize)
+             || mapping->getSize() != sizeof (Header) + (size_t) header.numBreaks * sizeof (juce::int64))
+            return {};
+
+        MappedBreaks result { mapping,
+                              reinterpret_cast<const juce::int64*> (static_cast<const char*> (mapping->getData()) + sizeof (Header)),
+                              (size_t) header.numBreaks,
+                              textSize };
+
+        if (! looksValid (result, text, textSize))
+            return {};
+
+        return result;
+    }
+
+    //==============================================================================
+    /**
+        Writes a cache file a chunk of breaks at a time while a file is being
+        scanned. The data goes to a temporary file, which only replaces the real
+        cache file once finish() has written a valid header.
+    */
+    class Writer
+    {
+    public:
+        Writer (const juce::File& fileToIndex, size_t numBytesToIndex)
+            : textFile (fileToIndex),
+              textFileSize ((juce::int64) numBytesToIndex),
+              textFileTime (fileToIndex.getLastModificationTime().toMilliseconds())
+        {
+            auto cacheFile = getCacheFileFor (textFile);
+
+            if (! cacheFile.getParentDirectory().createDirectory())
+                return;
+
+            tempFile.reset (new juce::TemporaryFile (cacheFile));
+            stream.reset (new juce::FileOutputStream (tempFile->getFile()));
+
+            if (! stream->openedOk())
+            {
+                stream.reset();
+                return;
+            }
+
+            Header placeholder {};
+            stream->write (&placeholder, sizeof (placeholder));
+        }
+
+        void addBreaks (const std::vector<juce::int64>& breaks)
+        {
+            if (stream != nullptr && ! breaks.empty())
+            {
+                stream->write (breaks.data(), breaks.size() * sizeof (juce::int64));
+                numBreaks += (juce::int64) breaks.size();
+            }
+        }
+
+        /** Commits the cache file, provided the text file hasn't changed since the
+            writer was created.
+        */
+        bool finish()
+        {
+            if (stream == nullptr
+                 || textFile.getSize() != textFileSize
+                 || textFile.getLastModificationTime().toMilliseconds() != textFileTime)
+                return false;
+
+            auto header = Header::create (textFile, textFileSize, textFileTime, numBreaks);
+
+            if (! stream->setPosition (0) || ! stream->write (&header, sizeof (header)))
+                return false;
+
+            stream->flush();
+            auto ok = stream->getStatus().wasOk();
+            stream.reset();
+
+            return ok && tempFile->overwriteTargetFileWithTemporary();
+        }
+
+    private:
+        juce::File textFile;
+        juce::int64 textFileSize, textFileTime;
+        juce::int64 numBreaks = 0;
+        std::unique_ptr<juce::TemporaryFile> tempFile;
+        std::unique_ptr<juce::FileOutputStream> stream;
+
+        JUCE_DECLARE_NON_COPYABLE (Writer)
+    };
+
+private:
+    //==============================================================================
+    struct Header
+    {
+        char magic[8];
+        juce::uint32 version, headerSize;
+        juce::int64 textFileSize, textFileTime, numBreaks;
+        juce::uint64 pathHash, checksum;
+        char reserved[8];
+
+        static Header create (const juce::File& textFile, juce::int64 size, juce::int64 time, juce::int64 numBreaks)
+        {
+            Header h {};
+            std::memcpy (h.magic, getMagic(), sizeof (h.magic));
+            h.version      = currentVersion;
+            h.headerSize   = (juce::uint32) sizeof (Header);
+            h.textFileSize = size;
+            h.textFileTime = time;
+            h.numBreaks    = numBreaks;
+            h.pathHash     = (juce::uint64) textFile.getFullPathName().hashCode64();
+            h.checksum     = h.calculateChecksum();
+            return h;
+        }
+
+        bool matches (const juce::File& textFile, size_t currentTextSize) const
+        {
+            return std::memcmp (magic, getMagic(), sizeof (magic)) == 0
+                && version == currentVersion
+                && headerSize == (juce::uint32) sizeof (Header)
+                && checksum == calculateChecksum()
+                && pathHash == (juce::uint64) textFile.getFullPathName().hashCode64()
+                && textFileSize == (juce::int64) currentTextSize
+                && textFileSize == textFile.getSize()
+                && textFileTime == textFile.getLastModificationTime().toMilliseconds()
+                && numBreaks >= 0;
+        }
+
+        // FNV-1a over every field before the checksum.
+        juce::uint64 calculateChecksum() const noexcept
+        {
+            auto* bytes = reinterpret_cast<const juce::uint8*> (this);
+            juce::uint64 hash = 0xcbf29ce484222325ull;
+
+            for (size_t i = 0; i < offsetof (Header, checksum); ++i)
+                hash = (hash ^ bytes[i]) * 0x100000001b3ull;
+
+            return hash;
+        }
+
+        // The byte order is part of the magic, so a cache can't be misread on a
+        // machine with a different endianness.
+        static const char* getMagic() noexcept
+        {
+           #if JUCE_LITTLE_ENDIAN
+            return "LIDXle\0";
+           #else
+            return "LIDXbe\0";
+           #endif
+        }
+
+        static constexpr juce::uint32 currentVersion = 1;
+    };
+
+    static_assert (sizeof (Header) == 64, "The breaks should start on a 64-byte boundary");
+
+    // Every offset is checked to be in order and inside the text, as the views
+    // read the text between consecutive breaks, and a corrupt cache mustn't send
+    // them past the end of it. That's one pass over the breaks, which is far
+    // smaller than the text, so only a spread of samples are also checked to
+    // follow a newline, rather than paying as much as rescanning the file.
+    static bool looksValid (const MappedBreaks& cached, const char* text, size_t textSize)
+    {
+        juce::int64 previous = 0;
+
+        for (size_t i = 0; i < cached.numBreaks; ++i)
+        {
+            auto offset = cached.breaks[i];
+
+            if (offset <= previous || offset > (juce::int64) textSize)
+                return false;
+
+            previous = offset;
+        }
+
+        const size_t numSamples = 64;
+
+        for (size_t i = 0; i < numSamples && cached.numBreaks > 0; ++i)
+            if (text[cached.breaks[(cached.numBreaks - 1) * i / (numSamples - 1)] - 1] != '\n')
+                return false;
+
+        // Nothing after the last break may be a newline.
+        auto tailStart = cached.numBreaks > 0 ? (size_t) cached.breaks[cached.numBreaks - 1] : 0;
+        return std::memchr (text + tailStart, '\n', textSize - tailStart) == nullptr;
+    }
+};
@@ -0,0 +1,200 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE tutorials.
+   Copyright (c) 2020 - Raw Material Software Limited
+
+   The code included in this file is provided under the terms of the ISC license
+   http://www.isc.org/downloads/software-support-policy/isc-license. Permission
+   To use, copy, modify, and/or distribute this software for any purpose with or
+   without fee is hereby granted provided that the above copyright notice and
+   this permission notice appear in all copies.
+
+   THE SOFTWARE IS PROVIDED "AS IS" WITHOUT ANY WARRANTY, AND ALL WARRANTIES,
+   WHETHER EXPRESSED OR IMPLIED, INCLUDING MERCHANTABILITY AND FITNESS FOR
+   PURPOSE, ARE DISCLAIMED.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#if JUCE_INTEL
+ #include <immintrin.h>
+#endif
+
+//==============================================================================
+/**
+    Finds the line and word boundaries in a block of text in a single pass.
+
+    Rather than looking at one character at a time like readNextLine() or
+    readUpToNextSpace(), this compares 16 (SSE2) or 32 (AVX2) bytes at once and
+    turns the matches into bitmasks, so it runs at close to memory bandwidth.
+    A scalar version is used on CPUs without those instruction sets.
+
+    Every offset that is produced is the position just after a delimiter, i.e. the
+    start of the following line or word.
+*/
+struct TextScanner
+{
+    enum class Implementation
+    {
+        best,
+        scalar,
+        sse2,
+        avx2
+    };
+
+    /** Returns true if the given implementation can run on this machine. */
+    static bool isAvailable (Implementation impl)
+    {
+        switch (impl)
+        {
+            case Implementation::best:
+            case Implementation::scalar:  return true;
+           #if JUCE_INTEL
+            case Implementation::sse2:    return true;
+            case Implementation::avx2:    return hasAVX2Support && juce::SystemStats::hasAVX2();
+           #else
+            case Implementation::sse2:
+            case Implementation::avx2:    return false;
+           #endif
+        }
+
+        return false;
+    }
+
+    static const char* getName (Implementation impl)
+    {
+        switch (impl)
+        {
+            case Implementation::best:    return "best";
+            case Implementation::scalar:  return "scalar";
+            case Implementation::sse2:    return "sse2";
+            case Implementation::avx2:    return "avx2";
+        }
+
+        return {};
+    }
+
+    /** Appends the offset following every '\n' to lineBreaks and, if wordBreaks
+        isn't null, the offset following every ' ' to wordBreaks. baseOffset is
+        added to every offset, so a large file can be scanned a piece at a time.
+    */
+    static void findBreaks (const char* data, size_t numBytes, juce::int64 baseOffset,
+                            std::vector<juce::int64>& lineBreaks,
+                            std::vector<juce::int64>* wordBreaks = nullptr,
+                            Implementation impl = Implementation::best)
+    {
+        if (impl == Implementation::best)
+            impl = isAvailable (Implementation::avx2) ? Implementation::avx2
+                 : isAvailable (Implementation::sse2) ? Implementation::sse2
+                                                      : Implementation::scalar;
+
+        jassert (isAvailable (impl));
+
+       #if JUCE_INTEL
+        if (impl == Implementation::avx2)
+            return scanAVX2 (data, numBytes, baseOffset, lineBreaks, wordBreaks);
+
+        if (impl == Implementation::sse2)
+            return scanSSE2 (data, numBytes, baseOffset, lineBreaks, wordBreaks);
+       #endif
+
+        scanScalar (data, numBytes, baseOffset, lineBreaks, wordBreaks);
+    }
+
+private:
+    static void scanScalar (const char* data, size_t numBytes, juce::int64 baseOffset,
+                            std::vector<juce::int64>& lineBreaks,
+                            std::vector<juce::int64>* wordBreaks)
+    {
+        for (size_t i = 0; i < numBytes; ++i)
+        {
+            if (data[i] == '\n')
+                lineBreaks.push_back (baseOffset + (juce::int64) i + 1);
+            else if (data[i] == ' ' && wordBreaks != nullptr)
+                wordBreaks->push_back (baseOffset + (juce::int64) i + 1);
+        }
+    }
+
+    static int countTrailingZeros (juce::uint32 bits) noexcept
+    {
+       #if JUCE_MSVC
+        unsigned long index;
+        _BitScanForward (&index, bits);
+        return (int) index;
+       #else
+        return __builtin_ctz (bits);
+       #endif
+    }
+
+    static void appendMatches (juce::uint32 mask, juce::int64 blockOffset, std::vector<juce::int64>& breaks)
+    {
+        while (mask != 0)
+        {
+            breaks.push_back (blockOffset + countTrailingZeros (mask) + 1);
+            mask &= mask - 1;
+        }
+    }
+
+   #if JUCE_INTEL
+    static void scanSSE2 (const char* data, size_t numBytes, juce::int64 baseOffset,
+                          std::vector<juce::int64>& lineBreaks,
+                          std::vector<juce::int64>* wordBreaks)
+    {
+        const auto newLines = _mm_set1_epi8 ('\n');
+        const auto spaces   = _mm_set1_epi8 (' ');
+        size_t i = 0;
+
+        for (; i + 16 <= numBytes; i += 16)
+        {
+            auto block = _mm_loadu_si128 (reinterpret_cast<const __m128i*> (data + i));
+            auto blockOffset = baseOffset + (juce::int64) i;
+
+            appendMatches ((juce::uint32) _mm_movemask_epi8 (_mm_cmpeq_epi8 (block, newLines)), blockOffset, lineBreaks);
+
+            if (wordBreaks != nullptr)
+                appendMatches ((juce::uint32) _mm_movemask_epi8 (_mm_cmpeq_epi8 (block, spaces)), blockOffset, *wordBreaks);
+        }
+
+        scanScalar (data + i, numBytes - i, baseOffset + (juce::int64) i, lineBreaks, wordBreaks);
+    }
+
+   #if JUCE_GCC || JUCE_CLANG
+    #define TEXT_SCANNER_AVX2_TARGET __attribute__ ((target ("avx2")))
+    static constexpr bool hasAVX2Support = true;
+   #elif JUCE_MSVC
+    #define TEXT_SCANNER_AVX2_TARGET
+    static constexpr bool hasAVX2Support = true;
+   #else
+    #define TEXT_SCANNER_AVX2_TARGET
+    static constexpr bool hasAVX2Support = false;
+   #endif
+
+    TEXT_SCANNER_AVX2_TARGET
+    static void scanAVX2 (const char* data, size_t numBytes, juce::int64 baseOffset,
+                          std::vector<juce::int64>& lineBreaks,
+                          std::vector<juce::int64>* wordBreaks)
+    {
+        const auto newLines = _mm256_set1_epi8 ('\n');
+        const auto spaces   = _mm256_set1_epi8 (' ');
+        size_t i = 0;
+
+        for (; i + 32 <= numBytes; i += 32)
+        {
+            auto block = _mm256_loadu_si256 (reinterpret_cast<const __m256i*> (data + i));
+            auto blockOffset = baseOffset + (juce::int64) i;
+
+            appendMatches ((juce::uint32) _mm256_movemask_epi8 (_mm256_cmpeq_epi8 (block, newLines)), blockOffset, lineBreaks);
+
+            if (wordBreaks != nullptr)
+                appendMatches ((juce::uint32) _mm256_movemask_epi8 (_mm256_cmpeq_epi8 (block, spaces)), blockOffset, *wordBreaks);
+        }
+
+        scanSSE2 (data + i, numBytes - i, baseOffset + (juce::int64) i, lineBreaks, wordBreaks);
+    }
+
+    #undef TEXT_SCANNER_AVX2_TARGET
+   #endif
+};
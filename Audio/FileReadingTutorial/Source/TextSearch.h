@@ -0,0 +1,172 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE tutorials.
+   Copyright (c) 2020 - Raw Material Software Limited
+
+   The code included in this file is provided under the terms of the ISC license
+   http://www.isc.org/downloads/software-support-policy/isc-license. Permission
+   To use, copy, modify, and/or distribute this software for any purpose with or
+   without fee is hereby granted provided that the above copyright notice and
+   this permission notice appear in all copies.
+
+   THE SOFTWARE IS PROVIDED "AS IS" WITHOUT ANY WARRANTY, AND ALL WARRANTIES,
+   WHETHER EXPRESSED OR IMPLIED, INCLUDING MERCHANTABILITY AND FITNESS FOR
+   PURPOSE, ARE DISCLAIMED.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "TextScanner.h"
+
+//==============================================================================
+/**
+    Finds every occurrence of a string in a block of text.
+
+    The SIMD versions compare the first and the last byte of the pattern against
+    16 (SSE2) or 32 (AVX2) positions at once, and only the positions where both
+    match are checked in full, so on ordinary text almost nothing but the two
+    vector compares is ever done. The scalar version uses memchr() to find
+    candidates for the first byte.
+
+    Only occurrences that lie entirely within the block are found, so a large
+    file can be searched a piece at a time as long as consecutive pieces overlap
+    by one byte less than the length of the pattern.
+*/
+struct TextSearch
+{
+    using Implementation = TextScanner::Implementation;
+
+    /** Appends the offset of every occurrence of the pattern to matches, adding
+        baseOffset to each one. Overlapping occurrences are all reported.
+    */
+    static void findAll (const char* data, size_t numBytes,
+                         const char* pattern, size_t patternLength,
+                         juce::int64 baseOffset, std::vector<juce::int64>& matches,
+                         Implementation impl = Implementation::best)
+    {
+        if (patternLength == 0 || patternLength > numBytes)
+            return;
+
+        if (impl == Implementation::best)
+            impl = TextScanner::isAvailable (Implementation::avx2) ? Implementation::avx2
+                 : TextScanner::isAvailable (Implementation::sse2) ? Implementation::sse2
+                                                                   : Implementation::scalar;
+
+        jassert (TextScanner::isAvailable (impl));
+
+       #if JUCE_INTEL
+        if (impl == Implementation::avx2)
+            return searchAVX2 (data, numBytes, pattern, patternLength, baseOffset, matches);
+
+        if (impl == Implementation::sse2)
+            return searchSSE2 (data, numBytes, pattern, patternLength, baseOffset, matches);
+       #endif
+
+        searchScalar (data, numBytes, pattern, patternLength, baseOffset, matches);
+    }
+
+private:
+    static void searchScalar (const char* data, size_t numBytes,
+                              const char* pattern, size_t patternLength,
+                              juce::int64 baseOffset, std::vector<juce::int64>& matches)
+    {
+        auto* end  = data + numBytes - patternLength + 1;
+        auto* next = data;
+
+        while (next < end)
+        {
+            auto* candidate = static_cast<const char*> (std::memchr (next, pattern[0], (size_t) (end - next)));
+
+            if (candidate == nullptr)
+                break;
+
+            if (std::memcmp (candidate + 1, pattern + 1, patternLength - 1) == 0)
+                matches.push_back (baseOffset + (juce::int64) (candidate - data));
+
+            next = candidate + 1;
+        }
+    }
+
+    // Checks each candidate position in a mask whose first and last bytes matched.
+    static void checkCandidates (juce::uint32 mask, const char* block, juce::int64 blockOffset,
+                                 const char* pattern, size_t patternLength,
+                                 std::vector<juce::int64>& matches)
+    {
+        while (mask != 0)
+        {
+            auto bit = countTrailingZeros (mask);
+
+            if (patternLength <= 2 || std::memcmp (block + bit + 1, pattern + 1, patternLength - 2) == 0)
+                matches.push_back (blockOffset + bit);
+
+            mask &= mask - 1;
+        }
+    }
+
+    static int countTrailingZeros (juce::uint32 bits) noexcept
+    {
+       #if JUCE_MSVC
+        unsigned long index;
+        _BitScanForward (&index, bits);
+        return (int) index;
+       #else
+        return __builtin_ctz (bits);
+       #endif
+    }
+
+   #if JUCE_INTEL
+    static void searchSSE2 (const char* data, size_t numBytes,
+                            const char* pattern, size_t patternLength,
+                            juce::int64 baseOffset, std::vector<juce::int64>& matches)
+    {
+        const auto first = _mm_set1_epi8 (pattern[0]);
+        const auto last  = _mm_set1_epi8 (pattern[patternLength - 1]);
+        size_t i = 0;
+
+        for (; i + patternLength - 1 + 16 <= numBytes; i += 16)
+        {
+            auto blockFirst = _mm_loadu_si128 (reinterpret_cast<const __m128i*> (data + i));
+            auto blockLast  = _mm_loadu_si128 (reinterpret_cast<const __m128i*> (data + i + patternLength - 1));
+            auto mask = _mm_movemask_epi8 (_mm_and_si128 (_mm_cmpeq_epi8 (blockFirst, first),
+                                                          _mm_cmpeq_epi8 (blockLast, last)));
+
+            checkCandidates ((juce::uint32) mask, data + i, baseOffset + (juce::int64) i, pattern, patternLength, matches);
+        }
+
+        searchScalar (data + i, numBytes - i, pattern, patternLength, baseOffset + (juce::int64) i, matches);
+    }
+
+   #if JUCE_GCC || JUCE_CLANG
+    #define TEXT_SEARCH_AVX2_TARGET __attribute__ ((target ("avx2")))
+   #else
+    #define TEXT_SEARCH_AVX2_TARGET
+   #endif
+
+    TEXT_SEARCH_AVX2_TARGET
+    static void searchAVX2 (const char* data, size_t numBytes,
+                            const char* pattern, size_t patternLength,
+                            juce::int64 baseOffset, std::vector<juce::int64>& matches)
+    {
+        const auto first = _mm256_set1_epi8 (pattern[0]);
+        const auto last  = _mm256_set1_epi8 (pattern[patternLength - 1]);
+        size_t i = 0;
+
+        for (; i + patternLength - 1 + 32 <= numBytes; i += 32)
+        {
+            auto blockFirst = _mm256_loadu_si256 (reinterpret_cast<const __m256i*> (data + i));
+            auto blockLast  = _mm256_loadu_si256 (reinterpret_cast<const __m256i*> (data + i + patternLength - 1));
+            auto mask = _mm256_movemask_epi8 (_mm256_and_si256 (_mm256_cmpeq_epi8 (blockFirst, first),
+                                                                _mm256_cmpeq_epi8 (blockLast, last)));
+
+            checkCandidates ((juce::uint32) mask, data + i, baseOffset + (juce::int64) i, pattern, patternLength, matches);
+        }
+
+        searchSSE2 (data + i, numBytes - i, pattern, patternLength, baseOffset + (juce::int64) i, matches);
+    }
+
+    #undef TEXT_SEARCH_AVX2_TARGET
+   #endif
+};
@@ -0,0 +1,240 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE tutorials.
+   Copyright (c) 2020 - Raw Material Software Limited
+
+   The code included in this file is provided under the terms of the ISC license
+   http://www.isc.org/downloads/software-support-policy/isc-license. Permission
+   To use, copy, modify, and/or distribute this software for any purpose with or
+   without fee is hereby granted provided that the above copyright notice and
+   this permission notice appear in all copies.
+
+   THE SOFTWARE IS PROVIDED "AS IS" WITHOUT ANY WARRANTY, AND ALL WARRANTIES,
+   WHETHER EXPRESSED OR IMPLIED, INCLUDING MERCHANTABILITY AND FITNESS FOR
+   PURPOSE, ARE DISCLAIMED.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "TextFileStatistics.h"
+
+//==============================================================================
+/**
+    Shows the word and line statistics of a file: the totals, a histogram of the
+    line lengths, and a list of the most frequent words.
+
+    The counting is done in the background by a TextFileStatistics, and the
+    panel shows its progress until the results are ready. Only the words in the
+    list are ever turned into Strings, and only when their rows are drawn.
+*/
+class TextStatisticsPanel  : public juce::Component,
+                             private juce::ListBoxModel,
+                             private juce::Timer
+{
+public:
+    TextStatisticsPanel()
+    {
+        addAndMakeVisible (wordList);
+        wordList.setModel (this);
+        wordList.setRowHeight (getLineHeight());
+        wordList.setColour (juce::ListBox::backgroundColourId, juce::Colours::transparentBlack);
+
+        statistics.onFinished = [this]
+        {
+            stopTimer();
+            topWords = statistics.getStatistics().getMostFrequentWords (maximumNumWordsShown);
+            wordList.updateContent();
+            resized();
+            repaint();
+        };
+    }
+
+    ~TextStatisticsPanel() override
+    {
+        wordList.setModel (nullptr);
+    }
+
+    /** Starts counting a file in the background. Returns false if it can't be counted. */
+    bool count (const juce::File& file)
+    {
+        clear();
+        auto started = statistics.start (file);
+
+        if (started)
+            startTimer (progressIntervalMs);
+
+        repaint();
+        return started;
+    }
+
+    void clear()
+    {
+        stopTimer();
+        statistics.cancel();
+        topWords.clear();
+        wordList.updateContent();
+
+        resized();
+        repaint();
+    }
+
+    bool isCounting() const                 { return statistics.isCounting(); }
+
+    //==============================================================================
+    void paint (juce::Graphics& g) override
+    {
+        g.fillAll (findColour (juce::TextEditor::backgroundColourId));
+        g.setFont (font);
+
+        auto area = getLocalBounds().reduced (margin);
+        auto lineHeight = getLineHeight();
+
+        g.setColour (findColour (juce::TextEditor::textColourId));
+        g.drawText (statistics.getFile().getFileName(), area.removeFromTop (lineHeight), juce::Justification::centredLeft, true);
+
+        if (! statistics.isFinished())
+        {
+            if (statistics.isCounting())
+                g.drawText ("Counting... " + juce::String (juce::roundToInt (statistics.getProgress() * 100.0)) + "%",
+                            area.removeFromTop (lineHeight), juce::Justification::centredLeft, true);
+
+            return;
+        }
+
+        for (auto& line : getSummaryLines())
+            g.drawText (line, area.removeFromTop (lineHeight), juce::Justification::centredLeft, true);
+
+        area.removeFromTop (lineHeight / 2);
+        g.drawText ("Line lengths", area.removeFromTop (lineHeight), juce::Justification::centredLeft, true);
+
+        auto& stats = statistics.getStatistics();
+        auto buckets = getNonEmptyBuckets();
+        juce::uint64 mostLines = 1;
+
+        for (auto bucket = buckets.getStart(); bucket < buckets.getEnd(); ++bucket)
+            mostLines = juce::jmax (mostLines, stats.getNumLinesWithLength (bucket));
+
+        for (auto bucket = buckets.getStart(); bucket < buckets.getEnd(); ++bucket)
+        {
+            auto row = area.removeFromTop (lineHeight);
+            auto numLines = stats.getNumLinesWithLength (bucket);
+
+            g.setColour (findColour (juce::TextEditor::textColourId));
+            g.drawText (getBucketName (bucket), row.removeFromLeft (labelWidth), juce::Justification::centredLeft, true);
+            g.drawText (juce::String ((juce::int64) numLines), row.removeFromRight (labelWidth), juce::Justification::centredRight, true);
+
+            auto bar = row.reduced (4, 3).toFloat();
+            g.setColour (findColour (juce::TextEditor::highlightColourId));
+            g.fillRect (bar.withWidth (bar.getWidth() * (float) ((double) numLines / (double) mostLines)));
+        }
+
+        area.removeFromTop (lineHeight / 2);
+        g.setColour (findColour (juce::TextEditor::textColourId));
+        g.drawText ("Most frequent words", area.removeFromTop (lineHeight), juce::Justification::centredLeft, true);
+    }
+
+    void resized() override
+    {
+        auto area = getLocalBounds().reduced (margin);
+        auto lineHeight = getLineHeight();
+
+        if (statistics.isFinished())
+        {
+            auto numRows = 1 + (int) getSummaryLines().size() + 1 + getNonEmptyBuckets().getLength() + 1;
+            area.removeFromTop (numRows * lineHeight + lineHeight);
+            wordList.setBounds (area);
+        }
+        else
+        {
+            wordList.setBounds ({});
+        }
+    }
+
+private:
+    //==============================================================================
+    int getNumRows() override               { return (int) topWords.size(); }
+
+    void paintListBoxItem (int row, juce::Graphics& g, int width, int height, bool) override
+    {
+        if (! juce::isPositiveAndBelow (row, getNumRows()))
+            return;
+
+        auto& word = topWords[(size_t) row];
+
+        g.setFont (font);
+        g.setColour (findColour (juce::TextEditor::textColourId));
+        g.drawText (juce::String ((juce::int64) word.count), 0, 0, labelWidth, height, juce::Justification::centredLeft, true);
+        g.drawText (word.toString(), labelWidth, 0, width - labelWidth, height, juce::Justification::centredLeft, true);
+    }
+
+    void timerCallback() override
+    {
+        repaint();
+    }
+
+    //==============================================================================
+    juce::StringArray getSummaryLines() const
+    {
+        auto& stats = statistics.getStatistics();
+        juce::StringArray lines;
+
+        lines.add (juce::String ((juce::int64) stats.getNumWords()) + " words, "
+                     + (stats.isTruncated() ? "about " : "") + juce::String ((juce::int64) stats.getNumDistinctWords()) + " distinct");
+        lines.add (juce::String ((juce::int64) stats.getNumLines()) + " lines, longest "
+                     + juce::String ((juce::int64) stats.getLongestLine()) + " bytes");
+        lines.add (juce::File::descriptionOfSizeInBytes (statistics.getNumBytes())
+                     + " in " + juce::String (statistics.getSecondsTaken(), 2) + " s");
+
+        if (stats.isTruncated())
+            lines.add (juce::String ((juce::int64) stats.getNumWordsNotKept()) + " words not listed");
+
+        return lines;
+    }
+
+    // The range of buckets from the first with any lines to the last.
+    juce::Range<int> getNonEmptyBuckets() const
+    {
+        auto& stats = statistics.getStatistics();
+        int first = TextWordStatistics::numLineLengthBuckets, last = 0;
+
+        for (int bucket = 0; bucket < TextWordStatistics::numLineLengthBuckets; ++bucket)
+        {
+            if (stats.getNumLinesWithLength (bucket) > 0)
+            {
+                first = juce::jmin (first, bucket);
+                last = bucket + 1;
+            }
+        }
+
+        return { juce::jmin (first, last), last };
+    }
+
+    static juce::String getBucketName (int bucket)
+    {
+        auto start = TextWordStatistics::getBucketStart (bucket);
+
+        if (start <= 1)
+            return juce::String ((juce::int64) start);
+
+        return juce::String ((juce::int64) start) + "-" + juce::String ((juce::int64) (start * 2 - 1));
+    }
+
+    int getLineHeight() const               { return juce::roundToInt (font.getHeight() * 1.2f); }
+
+    //==============================================================================
+    static constexpr size_t maximumNumWordsShown = 1000;
+    static constexpr int progressIntervalMs = 100;
+    static constexpr int margin = 6;
+    static constexpr int labelWidth = 90;
+
+    TextFileStatistics statistics;
+    std::vector<TextWordStatistics::Word> topWords;
+    juce::ListBox wordList;
+    juce::Font font { juce::Font::getDefaultMonospacedFontName(), 13.0f, juce::Font::plain };
+
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TextStatisticsPanel)
+};
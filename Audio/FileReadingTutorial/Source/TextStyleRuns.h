@@ -0,0 +1,133 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE tutorials.
+   Copyright (c) 2020 - Raw Material Software Limited
+
+   The code included in this file is provided under the terms of the ISC license
+   http://www.isc.org/downloads/software-support-policy/isc-license. Permission
+   To use, copy, modify, and/or distribute this software for any purpose with or
+   without fee is hereby granted provided that the above copyright notice and
+   this permission notice appear in all copies.
+
+   THE SOFTWARE IS PROVIDED "AS IS" WITHOUT ANY WARRANTY, AND ALL WARRANTIES,
+   WHETHER EXPRESSED OR IMPLIED, INCLUDING MERCHANTABILITY AND FITNESS FOR
+   PURPOSE, ARE DISCLAIMED.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+//==============================================================================
+/**
+    Stores the colour and font style of a block of text as run-length spans.
+
+    Each run records only the byte offset where it starts, so a run lasts until
+    the next one begins. Runs are added in order and adjacent runs with the same
+    style are merged, which keeps even a heavily coloured file down to a few bytes
+    per style change, and finding the runs for a visible range is a binary search.
+*/
+class TextStyleRuns
+{
+public:
+    struct Run
+    {
+        juce::int64 start;
+        juce::uint32 colour;    // ARGB, or 0 to use the view's default text colour
+        int fontStyleFlags;     // a combination of juce::Font::FontStyleFlags
+    };
+
+    TextStyleRuns() = default;
+
+    void clear()
+    {
+        runs.clear();
+    }
+
+    /** Starts a new run at the given offset, which mustn't be before the last run. */
+    void addRun (juce::int64 start, juce::Colour colour, int fontStyleFlags = juce::Font::plain)
+    {
+        addRun ({ start, colour.getARGB(), fontStyleFlags });
+    }
+
+    void addRun (const Run& run)
+    {
+        if (! runs.empty())
+        {
+            auto& last = runs.back();
+            jassert (run.start >= last.start);
+
+            if (last.colour == run.colour && last.fontStyleFlags == run.fontStyleFlags)
+                return;
+
+            if (last.start == run.start)
+            {
+                last = run;
+                return;
+            }
+        }
+
+        runs.push_back (run);
+    }
+
+    /** Removes any runs that start at or after the given offset. */
+    void truncate (juce::int64 position)
+    {
+        while (! runs.empty() && runs.back().start >= position)
+            runs.pop_back();
+    }
+
+    void appendRuns (const std::vector<Run>& newRuns)
+    {
+        for (auto& run : newRuns)
+            addRun (run);
+    }
+
+    size_t getNumRuns() const noexcept     { return runs.size(); }
+    bool isEmpty() const noexcept          { return runs.empty(); }
+
+    /** Calls back with each styled piece of a byte range, in order:
+        callback (juce::Range<juce::int64>, juce::Colour, int fontStyleFlags).
+        Text before the first run is reported with a transparent colour.
+    */
+    template <typename Callback>
+    void forEachRun (juce::Range<juce::int64> range, Callback&& callback) const
+    {
+        auto position = range.getStart();
+        auto end = range.getEnd();
+
+        if (position >= end)
+            return;
+
+        auto run = std::upper_bound (runs.begin(), runs.end(), position,
+                                     [] (juce::int64 pos, const Run& r) { return pos < r.start; });
+
+        if (run == runs.begin())
+        {
+            auto pieceEnd = run != runs.end() ? juce::jmin (run->start, end) : end;
+            callback (juce::Range<juce::int64> (position, pieceEnd), juce::Colour(), (int) juce::Font::plain);
+            position = pieceEnd;
+        }
+        else
+        {
+            --run;
+        }
+
+        for (; position < end && run != runs.end(); ++run)
+        {
+            auto next = run + 1;
+            auto pieceEnd = next != runs.end() ? juce::jmin (next->start, end) : end;
+
+            if (pieceEnd > position)
+                callback (juce::Range<juce::int64> (position, pieceEnd), juce::Colour (run->colour), run->fontStyleFlags);
+
+            position = pieceEnd;
+        }
+    }
+
+private:
+    std::vector<Run> runs;
+
+    JUCE_LEAK_DETECTOR (TextStyleRuns)
+};
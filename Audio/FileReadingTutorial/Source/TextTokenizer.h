@@ -0,0 +1,166 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE tutorials.
+   Copyright (c) 2020 - Raw Material Software Limited
+
+   The code included in this file is provided under the terms of the ISC license
+   http://www.isc.org/downloads/software-support-policy/isc-license. Permission
+   To use, copy, modify, and/or distribute this software for any purpose with or
+   without fee is hereby granted provided that the above copyright notice and
+   this permission notice appear in all copies.
+
+   THE SOFTWARE IS PROVIDED "AS IS" WITHOUT ANY WARRANTY, AND ALL WARRANTIES,
+   WHETHER EXPRESSED OR IMPLIED, INCLUDING MERCHANTABILITY AND FITNESS FOR
+   PURPOSE, ARE DISCLAIMED.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+//==============================================================================
+/**
+    A word found by one of the tokenisers below.
+
+    It's just a view of the bytes, which stay in the buffer they were found in,
+    so producing a token never allocates. Like readUpToNextSpace(), a word
+    includes the space that ends it (if there is one).
+*/
+struct TextToken
+{
+    juce::int64 offset = 0;      // the token's position within the whole text
+    const char* data = nullptr;
+    size_t length = 0;
+
+    /** Only call this when you actually need a String, as it copies the text. */
+    juce::String toString() const     { return juce::String::fromUTF8 (data, (int) length); }
+};
+
+//==============================================================================
+/**
+    Splits a block of text that's already in memory (e.g. a MemoryMappedFile) into
+    space-separated words. Tokens point straight into the original data.
+*/
+class WordTokenizer
+{
+public:
+    WordTokenizer() = default;
+
+    WordTokenizer (const char* textData, size_t numBytes) noexcept
+        : data (textData), size (numBytes)
+    {
+    }
+
+    /** Finds the next word, returning false when the text has been used up. */
+    bool next (TextToken& token) noexcept
+    {
+        if (position >= size)
+            return false;
+
+        auto* start = data + position;
+        auto remaining = size - position;
+        auto* space = static_cast<const char*> (std::memchr (start, ' ', remaining));
+        auto length = space != nullptr ? (size_t) (space - start) + 1 : remaining;
+
+        token = { (juce::int64) position, start, length };
+        position += length;
+        return true;
+    }
+
+    size_t getPosition() const noexcept     { return position; }
+    bool isFinished() const noexcept        { return position >= size; }
+
+private:
+    const char* data = nullptr;
+    size_t size = 0, position = 0;
+};
+
+//==============================================================================
+/**
+    Splits the contents of an InputStream into space-separated words.
+
+    The stream is read a block at a time into one reusable buffer and tokens point
+    into that buffer, so a token is only valid until next() is called again. The
+    buffer only grows if a single word is longer than it, so words of any length
+    are returned whole and there's no allocation per word.
+*/
+class StreamWordTokenizer
+{
+public:
+    explicit StreamWordTokenizer (juce::InputStream& source, size_t initialBufferSize = 64 * 1024)
+        : stream (source), buffer (juce::jmax ((size_t) 16, initialBufferSize))
+    {
+    }
+
+    /** Finds the next word, returning false when the stream has been used up. */
+    bool next (TextToken& token)
+    {
+        for (;;)
+        {
+            auto* bufferData = static_cast<const char*> (buffer.getData());
+
+            if (auto* space = static_cast<const char*> (std::memchr (bufferData + searchPosition, ' ',
+                                                                     numBytesInBuffer - searchPosition)))
+            {
+                auto end = (size_t) (space - bufferData) + 1;
+                token = { bufferOffset + (juce::int64) tokenStart, bufferData + tokenStart, end - tokenStart };
+                tokenStart = searchPosition = end;
+                return true;
+            }
+
+            searchPosition = numBytesInBuffer;
+
+            if (sourceExhausted)
+            {
+                if (tokenStart == numBytesInBuffer)
+                    return false;
+
+                token = { bufferOffset + (juce::int64) tokenStart, bufferData + tokenStart, numBytesInBuffer - tokenStart };
+                tokenStart = numBytesInBuffer;
+                return true;
+            }
+
+            refill();
+        }
+    }
+
+private:
+    // Moves the unfinished word to the front of the buffer, grows the buffer if
+    // that word already fills it, then tops it up from the stream.
+    void refill()
+    {
+        auto* bufferData = static_cast<char*> (buffer.getData());
+        auto numUnfinished = numBytesInBuffer - tokenStart;
+
+        if (tokenStart > 0)
+        {
+            std::memmove (bufferData, bufferData + tokenStart, numUnfinished);
+            bufferOffset += (juce::int64) tokenStart;
+            searchPosition -= tokenStart;
+            numBytesInBuffer = numUnfinished;
+            tokenStart = 0;
+        }
+
+        if (numBytesInBuffer == buffer.getSize())
+        {
+            buffer.ensureSize (buffer.getSize() * 2);
+            bufferData = static_cast<char*> (buffer.getData());
+        }
+
+        auto numRead = stream.read (bufferData + numBytesInBuffer, (int) (buffer.getSize() - numBytesInBuffer));
+
+        if (numRead <= 0)
+            sourceExhausted = true;
+        else
+            numBytesInBuffer += (size_t) numRead;
+    }
+
+    juce::InputStream& stream;
+    juce::MemoryBlock buffer;
+    juce::int64 bufferOffset = 0;
+    size_t numBytesInBuffer = 0, tokenStart = 0, searchPosition = 0;
+    bool sourceExhausted = false;
+
+    JUCE_DECLARE_NON_COPYABLE (StreamWordTokenizer)
+};
@@ -0,0 +1,473 @@
+/*
+  ==============================================================================
+
+   This file is part of the JUCE tutorials.
+   Copyright (c) 2020 - Raw Material Software Limited
+
+   The code included in this file is provided under the terms of the ISC license
+   http://www.isc.org/downloads/software-support-policy/isc-license. Permission
+   To use, copy, modify, and/or distribute this software for any purpose with or
+   without fee is hereby granted provided that the above copyright notice and
+   this permission notice appear in all copies.
+
+   THE SOFTWARE IS PROVIDED "AS IS" WITHOUT ANY WARRANTY, AND ALL WARRANTIES,
+   WHETHER EXPRESSED OR IMPLIED, INCLUDING MERCHANTABILITY AND FITNESS FOR
+   PURPOSE, ARE DISCLAIMED.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include "TextTokenizer.h"
+#include "TextLineDiff.h"
+
+//==============================================================================
+/**
+    Counts the words and lines in a block of text: how often each distinct word
+    appears, how many distinct words there are, and how long the lines are.
+
+    The text has to stay in memory (e.g. in a MemoryMappedFile) for as long as
+    the statistics are used, because a word is never copied. The table holds one
+    view of each distinct word, pointing at its first occurrence, so counting
+    100M words costs no more memory than counting the distinct ones among them.
+
+    Words are found by WordTokenizer and split further at tabs, and are compared
+    byte for byte, so "Word" and "word," count as different words. Tokens longer
+    than maximumWordLength are counted, but not kept in the table, as they're
+    usually encoded data rather than words.
+
+    The table is limited to a maximum number of words. Once it's full, further
+    new words are only counted in the totals, and the number of distinct words
+    becomes an estimate (from a HyperLogLog sketch of all the words seen).
+
+    To count on several threads, each thread gives its share of the text to a
+    Counter. That counts into a small private table which stays in the cache, and
+    merges it into the shared statistics whenever it fills up.
+*/
+class TextWordStatistics
+{
+public:
+    /** A distinct word: a view of its first occurrence, and the number of times it appears. */
+    struct Word
+    {
+        juce::String toString() const       { return juce::String::fromUTF8 (data, (int) length); }
+
+        const char* data = nullptr;         // null marks an empty slot in the table
+        juce::uint32 length = 0, hash = 0;
+        juce::uint64 count = 0;
+    };
+
+    static constexpr size_t maximumWordLength = 256;
+    static constexpr size_t defaultMaximumNumWords = 1 << 21;
+
+    /** Lines are counted in buckets by their length in bytes, not including the
+        line ending: 0, 1, 2-3, 4-7, 8-15 and so on.
+    */
+    static constexpr int numLineLengthBuckets = 48;
+
+    explicit TextWordStatistics (size_t maximumNumWords = defaultMaximumNumWords)
+        : words (maximumNumWords)
+    {
+    }
+
+    //==============================================================================
+    juce::uint64 getNumWords() const noexcept           { return numWords; }
+    juce::uint64 getNumLines() const noexcept           { return numLines; }
+    juce::uint64 getNumLongTokens() const noexcept      { return numLongTokens; }
+    juce::uint64 getLongestLine() const noexcept        { return longestLine; }
+
+    /** Returns true if some distinct words didn't fit in the table, in which case
+        getNumDistinctWords() is an estimate and some words are missing.
+    */
+    bool isTruncated() const noexcept                   { return numWordsNotKept > 0; }
+
+    /** Returns the number of words that weren't kept because the table was full. */
+    juce::uint64 getNumWordsNotKept() const noexcept    { return numWordsNotKept; }
+
+    juce::uint64 getNumDistinctWords() const
+    {
+        return isTruncated() ? juce::jmax ((juce::uint64) words.size(), sketch.getEstimate())
+                             : (juce::uint64) words.size();
+    }
+
+    juce::uint64 getNumLinesWithLength (int bucket) const noexcept      { return lineLengths[bucket]; }
+
+    /** Returns the shortest line length that's counted in a bucket. */
+    static juce::uint64 getBucketStart (int bucket) noexcept
+    {
+        return bucket == 0 ? 0 : (juce::uint64) 1 << (bucket - 1);
+    }
+
+    /** Returns the most frequent words, most frequent first. */
+    std::vector<Word> getMostFrequentWords (size_t maximumNumber) const
+    {
+        auto moreFrequent = [] (const Word& a, const Word& b) { return a.count > b.count; };
+
+        // A min-heap of the best so far, so this takes one pass over the table.
+        std::vector<Word> best;
+        best.reserve (maximumNumber);
+
+        words.forEachWord ([&] (const Word& word)
+        {
+            if (best.size() < maximumNumber)
+            {
+                best.push_back (word);
+                std::push_heap (best.begin(), best.end(), moreFrequent);
+            }
+            else if (maximumNumber > 0 && word.count > best.front().count)
+            {
+                std::pop_heap (best.begin(), best.end(), moreFrequent);
+                best.back() = word;
+                std::push_heap (best.begin(), best.end(), moreFrequent);
+            }
+        });
+
+        std::sort_heap (best.begin(), best.end(), moreFrequent);
+        return best;
+    }
+
+    /** Returns roughly how much memory the statistics are using. */
+    size_t getMemoryUsage() const noexcept
+    {
+        return sizeof (*this) + words.getMemoryUsage();
+    }
+
+    //==============================================================================
+    class Counter;
+
+private:
+    //==============================================================================
+    // Open addressing with linear probing. The slots are grown up to a fixed
+    // limit and kept at most half full.
+    class WordTable
+    {
+    public:
+        explicit WordTable (size_t maximumNumWordsToKeep)
+            : maximumNumWords (juce::jmax ((size_t) 1, maximumNumWordsToKeep))
+        {
+            resize (juce::jmin ((size_t) 1024, getMaximumNumSlots()));
+        }
+
+        /** Adds to a word's count, returning false if it's new and there's no room for it. */
+        bool add (const char* data, juce::uint32 length, juce::uint32 hash, juce::uint64 count)
+        {
+            auto i = findSlot (data, length, hash);
+
+            if (slots[i].data != nullptr)
+            {
+                slots[i].count += count;
+                return true;
+            }
+
+            if (numWords >= maximumNumWords)
+                return false;
+
+            if ((numWords + 1) * 2 > slots.size() && slots.size() < getMaximumNumSlots())
+            {
+                resize (slots.size() * 2);
+                i = findSlot (data, length, hash);
+            }
+
+            slots[i] = { data, length, hash, count };
+            ++numWords;
+            return true;
+        }
+
+        template <typename Callback>
+        void forEachWord (Callback&& callback) const
+        {
+            for (auto& slot : slots)
+                if (slot.data != nullptr)
+                    callback (slot);
+        }
+
+        size_t size() const noexcept                    { return numWords; }
+        size_t getMemoryUsage() const noexcept          { return slots.capacity() * sizeof (Word); }
+
+        /** Empties the table without giving back its slots. */
+        void clear()
+        {
+            std::fill (slots.begin(), slots.end(), Word());
+            numWords = 0;
+        }
+
+    private:
+        size_t getMaximumNumSlots() const noexcept
+        {
+            return (size_t) juce::nextPowerOfTwo ((int) juce::jmin (maximumNumWords, (size_t) 1 << 29)) * 2;
+        }
+
+        size_t findSlot (const char* data, juce::uint32 length, juce::uint32 hash) const noexcept
+        {
+            for (auto i = (size_t) hash & mask;; i = (i + 1) & mask)
+            {
+                auto& slot = slots[i];
+
+                if (slot.data == nullptr
+                     || (slot.hash == hash && slot.length == length && std::memcmp (slot.data, data, length) == 0))
+                    return i;
+            }
+        }
+
+        void resize (size_t numSlots)
+        {
+            std::vector<Word> oldSlots (numSlots);
+            oldSlots.swap (slots);
+            mask = numSlots - 1;
+
+            for (auto& word : oldSlots)
+                if (word.data != nullptr)
+                    slots[findSlot (word.data, word.length, word.hash)] = word;
+        }
+
+        std::vector<Word> slots;
+        size_t mask = 0, numWords = 0, maximumNumWords;
+    };
+
+    //==============================================================================
+    // A HyperLogLog sketch, which estimates the number of distinct hashes it has
+    // seen to within a couple of percent in 4KB.
+    class DistinctCountSketch
+    {
+    public:
+        DistinctCountSketch()       { clear(); }
+
+        void add (juce::uint64 hash) noexcept
+        {
+            auto& reg = registers[hash >> (64 - indexBits)];
+            auto rest = (hash << indexBits) | ((juce::uint64) 1 << (indexBits - 1));
+            juce::uint8 rank = 1;
+
+            while ((rest & ((juce::uint64) 1 << 63)) == 0)
+            {
+                rest <<= 1;
+                ++rank;
+            }
+
+            reg = juce::jmax (reg, rank);
+        }
+
+        void merge (const DistinctCountSketch& other) noexcept
+        {
+            for (size_t i = 0; i < numRegisters; ++i)
+                registers[i] = juce::jmax (registers[i], other.registers[i]);
+        }
+
+        void clear() noexcept       { std::fill (std::begin (registers), std::end (registers), (juce::uint8) 0); }
+
+        juce::uint64 getEstimate() const noexcept
+        {
+            auto m = (double) numRegisters;
+            double sum = 0.0;
+            int numZeros = 0;
+
+            for (auto reg : registers)
+            {
+                sum += std::ldexp (1.0, -(int) reg);
+                numZeros += reg == 0 ? 1 : 0;
+            }
+
+            auto estimate = (0.7213 / (1.0 + 1.079 / m)) * m * m / sum;
+
+            if (estimate <= 2.5 * m && numZeros > 0)
+                estimate = m * std::log (m / numZeros);
+
+            return (juce::uint64) std::llround (estimate);
+        }
+
+    private:
+        static constexpr int indexBits = 12;
+        static constexpr size_t numRegisters = (size_t) 1 << indexBits;
+
+        juce::uint8 registers[numRegisters];
+    };
+
+    //==============================================================================
+    bool addWord (const char* data, juce::uint32 length, juce::uint64 hash, juce::uint64 count)
+    {
+        if (! words.add (data, length, (juce::uint32) hash, count))
+            return false;
+
+        ++numWords;
+        sketch.add (hash);
+        return true;
+    }
+
+    void addLine (juce::uint64 length) noexcept
+    {
+        auto bucket = 0;
+
+        for (auto n = length; n != 0 && bucket < numLineLengthBuckets - 1; n >>= 1)
+            ++bucket;
+
+        ++lineLengths[bucket];
+        ++numLines;
+        longestLine = juce::jmax (longestLine, length);
+    }
+
+    void merge (const TextWordStatistics& other)
+    {
+        // Words that don't fit are counted, but can't be kept.
+        other.words.forEachWord ([this] (const Word& word)
+        {
+            if (! words.add (word.data, word.length, word.hash, word.count))
+                numWordsNotKept += word.count;
+        });
+
+        sketch.merge (other.sketch);
+
+        numWords        += other.numWords;
+        numWordsNotKept += other.numWordsNotKept;
+        numLongTokens   += other.numLongTokens;
+        numLines        += other.numLines;
+        longestLine      = juce::jmax (longestLine, other.longestLine);
+
+        for (int i = 0; i < numLineLengthBuckets; ++i)
+            lineLengths[i] += other.lineLengths[i];
+    }
+
+    void clear()
+    {
+        words.clear();
+        sketch.clear();
+        numWords = numWordsNotKept = numLongTokens = numLines = longestLine = 0;
+        std::fill (std::begin (lineLengths), std::end (lineLengths), (juce::uint64) 0);
+    }
+
+    //==============================================================================
+    WordTable words;
+    DistinctCountSketch sketch;
+
+    juce::uint64 numWords = 0, numWordsNotKept = 0, numLongTokens = 0;
+    juce::uint64 numLines = 0, longestLine = 0;
+    juce::uint64 lineLengths[numLineLengthBuckets] = {};
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TextWordStatistics)
+};
+
+//==============================================================================
+/**
+    Counts one thread's share of a text into a small table of its own, which
+    is merged into the shared statistics under a lock whenever it fills up,
+    and by flush() once the thread has finished.
+*/
+class TextWordStatistics::Counter
+{
+public:
+    Counter (TextWordStatistics& statisticsToAddTo, juce::CriticalSection& lockToUse)
+        : total (statisticsToAddTo), lock (lockToUse), partial (counterNumWords)
+    {
+    }
+
+    ~Counter()
+    {
+        flush();
+    }
+
+    /** Counts the lines that start in [start, end) of some text, and the words
+        in them. As with TextLineDiff::hashLines(), a line belongs to the block
+        containing the newline before it, so a text split into consecutive
+        blocks counts every line and word exactly once.
+    */
+    void addBlock (const char* data, size_t size, size_t start, size_t end)
+    {
+        size_t lineStart;
+
+        if (start == 0)
+        {
+            lineStart = 0;
+        }
+        else
+        {
+            auto* newLine = static_cast<const char*> (std::memchr (data + start, '\n', end - start));
+
+            if (newLine == nullptr)
+                return;
+
+            lineStart = (size_t) (newLine - data) + 1;
+        }
+
+        while (lineStart < size)
+        {
+            auto* newLine = static_cast<const char*> (std::memchr (data + lineStart, '\n', size - lineStart));
+            auto lineEnd = newLine != nullptr ? (size_t) (newLine - data) + 1 : size;
+
+            addLine (data + lineStart, lineEnd - lineStart);
+
+            if (lineEnd > end)
+                break;
+
+            lineStart = lineEnd;
+        }
+    }
+
+    /** Merges everything counted so far into the shared statistics. */
+    void flush()
+    {
+        const juce::ScopedLock sl (lock);
+        total.merge (partial);
+        partial.clear();
+    }
+
+private:
+    void addLine (const char* line, size_t length)
+    {
+        WordTokenizer tokenizer (line, length);
+        TextToken token;
+
+        while (tokenizer.next (token))
+        {
+            auto* word = token.data;
+            auto* tokenEnd = token.data + token.length;
+
+            while (word < tokenEnd)
+            {
+                auto* tab = static_cast<const char*> (std::memchr (word, '\t', (size_t) (tokenEnd - word)));
+                auto* wordEnd = tab != nullptr ? tab : tokenEnd;
+                auto* next = tab != nullptr ? tab + 1 : tokenEnd;
+
+                while (wordEnd > word && isSpace (wordEnd[-1]))
+                    --wordEnd;
+
+                if (wordEnd > word)
+                    addWord (word, (size_t) (wordEnd - word));
+
+                word = next;
+            }
+        }
+
+        while (length > 0 && (line[length - 1] == '\n' || line[length - 1] == '\r'))
+            --length;
+
+        partial.addLine ((juce::uint64) length);
+    }
+
+    void addWord (const char* word, size_t length)
+    {
+        if (length > maximumWordLength)
+        {
+            ++partial.numWords;
+            ++partial.numLongTokens;
+            return;
+        }
+
+        auto hash = TextLineDiff::hashLine (word, length);
+
+        if (! partial.addWord (word, (juce::uint32) length, hash, 1))
+        {
+            flush();
+            partial.addWord (word, (juce::uint32) length, hash, 1);
+        }
+    }
+
+    static bool isSpace (char c) noexcept       { return c == ' ' || c == '\r' || c == '\n'; }
+
+    static constexpr size_t counterNumWords = 1 << 14;
+
+    TextWordStatistics& total;
+    juce::CriticalSection& lock;
+    TextWordStatistics partial;
+
+    JUCE_DECLARE_NON_COPYABLE (Counter)
+};